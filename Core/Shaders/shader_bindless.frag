@@ -0,0 +1,19 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// set 1为全局bindless描述符集，纹理索引由推送常量传入
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+// 推送常量的前64字节是顶点阶段的模型矩阵
+layout(push_constant) uniform PushConstants {
+    layout(offset = 64) uint textureIndex;
+} pc;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(textures[pc.textureIndex], fragTexCoord);
+}
@@ -22,19 +22,36 @@ Application::Application()
 	// 初始化日志系统
 	Log::Init();
 
+	// 主线程之外的核心都交给工作线程
+	m_ThreadPool = CreateScope<ThreadPool>(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
 	m_Window = CreateScope<Window>();
 	m_Window->Init();
 
 	auto& swap = m_Window->GetSwapChain();
-	auto shader = VulkanShader::Init();
+	// 先注册所有着色器，各阶段在工作线程上并行编译
+	m_ShaderLibrary = CreateScope<ShaderLibrary>();
+	// bindless模式下片段着色器通过推送常量中的索引访问全局纹理数组
+	bool bindless = VulkanContext::Get()->GetDevice()->GetBindlessDescriptors() != nullptr;
+	m_ShaderLibrary->Load("Default", "Shaders/shader.vert", bindless ? "Shaders/shader_bindless.frag" : "Shaders/shader.frag");
+
+	auto shader = m_ShaderLibrary->Get("Default");
 	auto device = VulkanContext::Get()->GetCurrentDevice();
 	Ref <VulkanPipeline> pipeline = VulkanPipeline::Create(shader);
 	m_Renderer = CreateScope<VulkanRenderer>();
 	m_Renderer->Init(pipeline);
+
+	const auto& config = VulkanContext::Get()->GetConfig();
+	if (config.ShaderHotReload)
+		m_ShaderLibrary->EnableHotReload(std::chrono::milliseconds(config.ShaderHotReloadPollIntervalMs));
 }
 
 Application::~Application()
 {
+	// 重新加载回调会访问渲染器，先停止监视
+	m_ShaderLibrary->DisableHotReload();
+	// 等待后台的着色器与管线编译结束，它们使用的设备即将销毁
+	m_ThreadPool->WaitIdle();
 	m_Renderer->Shutdown();
 }
 
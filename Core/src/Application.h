@@ -3,8 +3,10 @@
 #include <vulkan/vulkan.h>
 
 #include "Renderer/VulkanRenderer.h"
+#include "Renderer/ShaderLibrary.h"
 
 #include "Base/Window.h"
+#include "Base/ThreadPool.h"
 
 class Application
 {
@@ -17,10 +19,15 @@ public:
 
 	static inline Application& Get() { return *s_Instance; }
 	inline Window& GetWindow() { return *m_Window; }
+	inline ThreadPool& GetThreadPool() { return *m_ThreadPool; }
+	inline ShaderLibrary& GetShaderLibrary() { return *m_ShaderLibrary; }
 private:
 	static Application* s_Instance;
 
+	// 最先构造、最后析构，渲染器与窗口销毁时工作线程不再执行任务
+	Scope<ThreadPool> m_ThreadPool;
 	Scope<Window> m_Window;
+	Scope<ShaderLibrary> m_ShaderLibrary;
 	Scope<VulkanRenderer> m_Renderer;
 
 	bool m_Running = true;
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "FileWatcher.h"
+
+namespace Utils {
+
+	static std::filesystem::file_time_type GetLastWriteTime(const std::filesystem::path& filepath)
+	{
+		// 文件不存在或正在被替换时返回最小值
+		std::error_code error;
+		auto time = std::filesystem::last_write_time(filepath, error);
+		return error ? std::filesystem::file_time_type::min() : time;
+	}
+
+}
+
+FileWatcher::FileWatcher(Callback callback, std::chrono::milliseconds pollInterval)
+	: m_Callback(std::move(callback)), m_PollInterval(pollInterval)
+{
+	m_Thread = std::thread(&FileWatcher::WatchLoop, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+void FileWatcher::Watch(const std::filesystem::path& filepath)
+{
+	std::string key = filepath.lexically_normal().generic_string();
+
+	std::scoped_lock lock(m_Mutex);
+	if (m_Files.find(key) != m_Files.end())
+		return;
+
+	WatchedFile& file = m_Files[key];
+	file.Filepath = key;
+	file.LastWriteTime = Utils::GetLastWriteTime(file.Filepath);
+}
+
+void FileWatcher::Unwatch(const std::filesystem::path& filepath)
+{
+	std::scoped_lock lock(m_Mutex);
+	m_Files.erase(filepath.lexically_normal().generic_string());
+}
+
+void FileWatcher::Stop()
+{
+	{
+		std::scoped_lock lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_Condition.notify_all();
+
+	if (m_Thread.joinable())
+		m_Thread.join();
+}
+
+void FileWatcher::WatchLoop()
+{
+	while (true)
+	{
+		{
+			std::unique_lock lock(m_Mutex);
+			m_Condition.wait_for(lock, m_PollInterval, [this]() { return m_Stop; });
+			if (m_Stop)
+				return;
+		}
+
+		Poll();
+	}
+}
+
+void FileWatcher::Poll()
+{
+	std::vector<std::filesystem::path> changed;
+	{
+		std::scoped_lock lock(m_Mutex);
+		for (auto& [key, file] : m_Files)
+		{
+			auto writeTime = Utils::GetLastWriteTime(file.Filepath);
+			if (writeTime == file.LastWriteTime)
+			{
+				file.Pending = false;
+				continue;
+			}
+
+			// 与上次轮询相同说明写入已经结束
+			if (file.Pending && writeTime == file.PendingWriteTime)
+			{
+				file.LastWriteTime = writeTime;
+				file.Pending = false;
+				changed.push_back(file.Filepath);
+			}
+			else
+			{
+				file.PendingWriteTime = writeTime;
+				file.Pending = true;
+			}
+		}
+	}
+
+	// 回调中可能再调用Watch()，不能持有锁
+	for (const auto& filepath : changed)
+		m_Callback(filepath);
+}
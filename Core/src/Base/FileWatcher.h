@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// 在后台线程上轮询文件的修改时间，文件写入完成后回调
+// 修改时间需在连续两次轮询中保持不变才会回调，编辑器分多次写入时只触发一次。
+// 回调在监视线程上执行，可以阻塞，期间暂停轮询
+class FileWatcher
+{
+public:
+	using Callback = std::function<void(const std::filesystem::path&)>;
+
+	FileWatcher(Callback callback, std::chrono::milliseconds pollInterval);
+	~FileWatcher();
+
+	// 线程安全，重复添加同一文件无效果；文件可以暂时不存在
+	void Watch(const std::filesystem::path& filepath);
+	void Unwatch(const std::filesystem::path& filepath);
+
+	// 等待监视线程结束，正在执行的回调会先完成；之后不再回调
+	void Stop();
+private:
+	void WatchLoop();
+	void Poll();
+private:
+	struct WatchedFile
+	{
+		std::filesystem::path Filepath;
+		std::filesystem::file_time_type LastWriteTime;
+		std::filesystem::file_time_type PendingWriteTime;
+		bool Pending = false;
+	};
+
+	Callback m_Callback;
+	std::chrono::milliseconds m_PollInterval;
+
+	std::unordered_map<std::string, WatchedFile> m_Files;
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	bool m_Stop = false;
+
+	std::thread m_Thread;
+};
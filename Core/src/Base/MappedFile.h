@@ -0,0 +1,33 @@
+#pragma once
+
+// 只读映射整个文件，数据直到对象销毁前一直有效
+// 读取时由系统按页调入，不经过中间缓冲区
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// 文件不存在、为空或映射失败时返回false
+	bool Open(const std::filesystem::path& filepath);
+	void Close();
+
+	bool IsOpen() const { return m_Data != nullptr; }
+	const uint8_t* GetData() const { return m_Data; }
+	uint64_t GetSize() const { return m_Size; }
+private:
+	const uint8_t* m_Data = nullptr;
+	uint64_t m_Size = 0;
+
+#ifdef _WIN32
+	void* m_File = nullptr;
+	void* m_Mapping = nullptr;
+#else
+	int m_File = -1;
+#endif
+};
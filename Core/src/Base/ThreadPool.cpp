@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+
+static thread_local uint32_t s_ThreadIndex = UINT32_MAX;
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	threadCount = std::max(threadCount, 1u);
+
+	m_Threads.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+		m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+
+	CORE_INFO("ThreadPool: started {0} worker threads", threadCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::scoped_lock lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_Condition.notify_all();
+
+	for (auto& thread : m_Threads)
+		thread.join();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task, bool front)
+{
+	{
+		std::scoped_lock lock(m_Mutex);
+		if (front)
+			m_Tasks.push_front(std::move(task));
+		else
+			m_Tasks.push_back(std::move(task));
+	}
+	m_Condition.notify_one();
+}
+
+void ThreadPool::ParallelFor(uint32_t count, uint32_t minPerChunk, const std::function<void(uint32_t, uint32_t, uint32_t)>& func)
+{
+	if (count == 0)
+		return;
+
+	uint32_t chunkCount = std::clamp(count / std::max(minPerChunk, 1u), 1u, GetThreadCount());
+	uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+	chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	// 分段由调用线程和工作线程共同领取，工作线程都在执行长任务时调用线程独自完成所有分段
+	struct ParallelForState
+	{
+		std::atomic<uint32_t> NextChunk = 0;
+		std::atomic<uint32_t> CompletedChunks = 0;
+		std::mutex Mutex;
+		std::condition_variable Condition;
+		std::exception_ptr Exception;
+	};
+	auto state = std::make_shared<ParallelForState>();
+
+	// 分段领取完后才开始的任务不会再访问func
+	auto run = [state, &func, count, chunkSize, chunkCount]()
+	{
+		uint32_t chunk;
+		while ((chunk = state->NextChunk.fetch_add(1)) < chunkCount)
+		{
+			uint32_t begin = chunk * chunkSize;
+			uint32_t end = std::min(begin + chunkSize, count);
+			try
+			{
+				func(begin, end, chunk);
+			}
+			catch (...)
+			{
+				std::scoped_lock lock(state->Mutex);
+				if (!state->Exception)
+					state->Exception = std::current_exception();
+			}
+
+			if (state->CompletedChunks.fetch_add(1) + 1 == chunkCount)
+			{
+				std::scoped_lock lock(state->Mutex);
+				state->Condition.notify_all();
+			}
+		}
+	};
+
+	// 帧内的工作插到队首，不排在解码、编译等后台任务之后
+	for (uint32_t i = 1; i < chunkCount; i++)
+		Enqueue(run, true);
+
+	run();
+
+	std::unique_lock lock(state->Mutex);
+	state->Condition.wait(lock, [&state, chunkCount]() { return state->CompletedChunks.load() == chunkCount; });
+	if (state->Exception)
+		std::rethrow_exception(state->Exception);
+}
+
+void ThreadPool::WaitIdle()
+{
+	std::unique_lock lock(m_Mutex);
+	m_IdleCondition.wait(lock, [this]() { return m_Tasks.empty() && m_ActiveTaskCount == 0; });
+}
+
+uint32_t ThreadPool::GetCurrentThreadIndex()
+{
+	return s_ThreadIndex;
+}
+
+void ThreadPool::WorkerLoop(uint32_t threadIndex)
+{
+	s_ThreadIndex = threadIndex;
+
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+
+			// 退出前先执行完已提交的任务
+			if (m_Stopping && m_Tasks.empty())
+				return;
+
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+			m_ActiveTaskCount++;
+		}
+
+		task();
+		// 任务捕获的对象先释放，WaitIdle()返回后不会再有析构在工作线程上执行
+		task = nullptr;
+
+		{
+			std::scoped_lock lock(m_Mutex);
+			m_ActiveTaskCount--;
+			if (m_Tasks.empty() && m_ActiveTaskCount == 0)
+				m_IdleCondition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+// 固定数量的工作线程，执行提交的任务
+class ThreadPool
+{
+public:
+	ThreadPool(uint32_t threadCount);
+	~ThreadPool();
+
+	// 提交一个任务，返回的future可用于等待任务完成并取得返回值，任务抛出的异常在get()时重新抛出
+	template<typename Func>
+	auto Submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>>
+	{
+		using Result = std::invoke_result_t<std::decay_t<Func>>;
+
+		// std::function要求可复制，packaged_task只能移动，通过shared_ptr包装
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+		std::future<Result> future = task->get_future();
+		Enqueue([task]() { (*task)(); });
+		return future;
+	}
+
+	// 将[0, count)均分为至多GetThreadCount()段并行执行，func(begin, end, chunkIndex)，阻塞直到全部完成
+	// 每段至少minPerChunk个元素；任务插到队首，调用线程也参与执行，不会等待队列中的后台任务。
+	// 分段可能在任意线程上执行，第一个异常在返回前重新抛出；不能在工作线程中调用
+	void ParallelFor(uint32_t count, uint32_t minPerChunk, const std::function<void(uint32_t, uint32_t, uint32_t)>& func);
+
+	// 阻塞直到队列为空且没有正在执行的任务；不能在工作线程中调用
+	void WaitIdle();
+
+	uint32_t GetThreadCount() const { return (uint32_t)m_Threads.size(); }
+	// 当前线程在池中的索引，非工作线程返回UINT32_MAX
+	static uint32_t GetCurrentThreadIndex();
+private:
+	// front为true时插到队首，下一个空闲的工作线程立即执行
+	void Enqueue(std::function<void()> task, bool front = false);
+	void WorkerLoop(uint32_t threadIndex);
+private:
+	std::vector<std::thread> m_Threads;
+
+	std::deque<std::function<void()>> m_Tasks;
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	std::condition_variable m_IdleCondition;
+	uint32_t m_ActiveTaskCount = 0;
+	bool m_Stopping = false;
+};
@@ -3,4 +3,47 @@
 struct VulkanConfig
 {
 	uint32_t FramesInFlight = 3;
+
+	// 每个飞行帧的uniform区间大小，每帧开始时整体回收
+	uint64_t FrameUniformBufferSize = 1ull * 1024 * 1024;
+	// 每个描述符池可分配的集合数，池耗尽时在池链上追加新池
+	uint32_t DescriptorPoolSetCount = 256;
+	// 描述符集缓存中连续多少帧未使用的集合被回收，不小于FramesInFlight
+	uint32_t DescriptorSetCacheMaxAge = 120;
+
+	// 管线缓存文件，启动时读取，退出时写回
+	std::string PipelineCachePath = "cache/pipeline.cache";
+	// 按源码哈希索引的SPIR-V缓存目录
+	std::string ShaderCachePath = "cache/shaders";
+	// 烘焙好的纹理（预生成mip并按设备支持压缩为BC格式），关闭时每次启动解码源图像并在运行时生成mip
+	bool TextureCache = true;
+	std::string TextureCachePath = "cache/textures";
+	// TextureLoader每帧最多上传的纹理数据字节数，超出的留到之后的帧；每帧至少上传一个
+	uint64_t TextureUploadBudgetPerFrame = 32ull * 1024 * 1024;
+	// 流式纹理的显存预算，超出时驱逐最久未被请求的纹理的高级别
+	uint64_t TextureStreamingBudget = 256ull * 1024 * 1024;
+	// 流式纹理始终常驻的mip尾部：较长边不小于该尺寸的最小级别及以下
+	uint32_t TextureStreamingMipTailSize = 128;
+	// 监视着色器源文件，修改后在后台重新编译并替换管线
+	bool ShaderHotReload = true;
+	uint32_t ShaderHotReloadPollIntervalMs = 100;
+
+	// 常驻映射的上传暂存环形缓冲区大小
+	uint64_t StagingRingSize = 64ull * 1024 * 1024;
+
+	// 存在独立的传输队列族时，上传拷贝提交到传输队列，与渲染并行执行
+	bool UseTransferQueue = true;
+
+	// 用计算着色器生成mip链，一次调度生成多级；关闭或格式不支持时逐级blit
+	bool ComputeMipGeneration = true;
+
+	// 纹理与存储缓冲区注册到一个全局描述符集，着色器通过索引访问；设备不支持描述符索引时自动关闭
+	bool Bindless = false;
+	uint32_t BindlessMaxTextures = 4096;
+	uint32_t BindlessMaxStorageBuffers = 1024;
+
+	// 绘制命令分散到工作线程，各自录制二级命令缓冲区
+	bool ParallelRecording = true;
+	// 每个线程至少分到的绘制数量，绘制过少时并行录制得不偿失，仍在主线程内联录制
+	uint32_t ParallelRecordingMinDrawsPerThread = 64;
 };
\ No newline at end of file
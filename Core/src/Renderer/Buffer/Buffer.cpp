@@ -3,11 +3,9 @@
 
 #include "Renderer/VulkanContext.h"
 
-void VulkanBuffer::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+void VulkanBuffer::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VulkanAllocation& allocation)
 {
-	// TODO：你应该交给一个专门的类来处理缓冲区的创建和分配
-	auto device = VulkanContext::Get()->GetCurrentDevice();
-	auto physicalDevice = VulkanContext::Get()->GetPhysicalDevice();
+	auto device = VulkanContext::Get()->GetDevice();
 
 	VkBufferCreateInfo bufferInfo{};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -15,65 +13,34 @@ void VulkanBuffer::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkM
 	bufferInfo.usage = usage;
 	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-	VK_CHECK_RESULT(vkCreateBuffer(device, &bufferInfo, nullptr, &buffer));
-
-	VkMemoryRequirements memRequirements;
-	vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-
-	allocInfo.memoryTypeIndex = physicalDevice->GetMemoryTypeIndex(memRequirements.memoryTypeBits, properties);
+	VK_CHECK_RESULT(vkCreateBuffer(device->GetVulkanDevice(), &bufferInfo, nullptr, &buffer));
 
-	VK_CHECK_RESULT(vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory));
-
-	vkBindBufferMemory(device, buffer, bufferMemory, 0);
+	// 从设备分配器中子分配内存并绑定
+	allocation = device->GetAllocator().AllocateBuffer(buffer, properties);
 }
 
-void VulkanBuffer::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+void VulkanBuffer::DestroyBuffer(VkBuffer buffer, VulkanAllocation& allocation)
 {
-	auto device = VulkanContext::Get()->GetDevice();
-	auto commandPool = VulkanContext::Get()->GetSwapChain().GetCurrentDrawCommandPool();
-
-	VkCommandBufferAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool = commandPool;
-	allocInfo.commandBufferCount = 1;
-
-	VkCommandBuffer commandBuffer;
-	vkAllocateCommandBuffers(device->GetVulkanDevice(), &allocInfo, &commandBuffer);
-
-	VkCommandBufferBeginInfo beginInfo{};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-	vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-	VkBufferCopy copyRegion{};
-	copyRegion.size = size;
-	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-	vkEndCommandBuffer(commandBuffer);
-
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer;
-
-	auto graphicsQueue = device->GetGraphicsQueue();
-	vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(graphicsQueue);
+	VulkanContext::Get()->GetDevice()->GetAllocator().DestroyBuffer(buffer, allocation);
+}
 
-	vkFreeCommandBuffers(device->GetVulkanDevice(), commandPool, 1, &commandBuffer);
+void VulkanBuffer::Allocate(const void* dstdata, VkDeviceSize size, const VulkanAllocation& allocation)
+{
+	// 主机可见内存由分配器常驻映射，直接写入即可
+	CORE_ASSERT(allocation.MappedData, "Allocation is not host visible!");
+	memcpy(allocation.MappedData, dstdata, static_cast<size_t>(size));
 }
 
-void VulkanBuffer::Allocate(const void* dstdata, VkDeviceSize size, VkDeviceMemory memory)
+Ref<VulkanUploadHandle> VulkanBuffer::Upload(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset, VulkanUploadBatch* batch)
 {
-	auto device = VulkanContext::Get()->GetCurrentDevice();
-	void* data;
-	vkMapMemory(device, memory, 0, size, 0, &data);
-	memcpy(data, dstdata, static_cast<size_t>(size));
-	vkUnmapMemory(device, memory);
+	if (batch)
+	{
+		batch->UploadBuffer(dstBuffer, data, size, dstOffset);
+		return nullptr;
+	}
+
+	// 同一队列上的后续提交按顺序执行，这里不需要等待拷贝完成
+	VulkanUploadBatch uploadBatch;
+	uploadBatch.UploadBuffer(dstBuffer, data, size, dstOffset);
+	return uploadBatch.Submit();
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include "Renderer/Vulkan.h"
+#include "Renderer/VulkanAllocator.h"
+#include "Renderer/VulkanUploadBatch.h"
 
 struct Buffer
 {
@@ -50,7 +52,10 @@ struct Buffer
 
 struct VulkanBuffer
 {
-	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
-	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-	void Allocate(const void* dstdata, VkDeviceSize size, VkDeviceMemory memory);
+	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VulkanAllocation& allocation);
+	void DestroyBuffer(VkBuffer buffer, VulkanAllocation& allocation);
+	void Allocate(const void* dstdata, VkDeviceSize size, const VulkanAllocation& allocation);
+	// 经由设备暂存环把数据上传到设备本地缓冲区
+	// 传入batch时只记录拷贝，由调用方统一提交；否则单独提交，不阻塞CPU
+	Ref<VulkanUploadHandle> Upload(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0, VulkanUploadBatch* batch = nullptr);
 };
\ No newline at end of file
@@ -3,36 +3,19 @@
 
 #include "Renderer/VulkanContext.h"
 
-VulkanIndexBuffer::VulkanIndexBuffer(void* data, uint64_t size)
+VulkanIndexBuffer::VulkanIndexBuffer(void* data, uint64_t size, VulkanUploadBatch* batch)
     : m_Size(size)
 {
-    m_LocalData = Buffer::Copy(data, size);
-
-    auto device = VulkanContext::Get()->GetCurrentDevice();
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-    Allocate(data, size, stagingBufferMemory);
-
-    CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_IndexBuffer, m_IndexBufferMemory);
-
-    CopyBuffer(stagingBuffer, m_IndexBuffer, size);
-
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_IndexBuffer, m_IndexBufferAllocation);
+    Upload(m_IndexBuffer, data, size, 0, batch);
 }
 
 VulkanIndexBuffer::~VulkanIndexBuffer()
 {
-    auto device = VulkanContext::Get()->GetCurrentDevice();
-
-    vkDestroyBuffer(device, m_IndexBuffer, nullptr);
-    vkFreeMemory(device, m_IndexBufferMemory, nullptr);
+    DestroyBuffer(m_IndexBuffer, m_IndexBufferAllocation);
 }
 
-Ref<VulkanIndexBuffer> VulkanIndexBuffer::Create(void* data, uint64_t size)
+Ref<VulkanIndexBuffer> VulkanIndexBuffer::Create(void* data, uint64_t size, VulkanUploadBatch* batch)
 {
-    return CreateRef<VulkanIndexBuffer>(data, size);
+    return CreateRef<VulkanIndexBuffer>(data, size, batch);
 }
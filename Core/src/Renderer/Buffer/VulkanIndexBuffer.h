@@ -6,10 +6,10 @@
 class VulkanIndexBuffer : public VulkanBuffer
 {
 public:
-	VulkanIndexBuffer(void* data, uint64_t size);
+	VulkanIndexBuffer(void* data, uint64_t size, VulkanUploadBatch* batch = nullptr);
 	~VulkanIndexBuffer();
 
-	static Ref<VulkanIndexBuffer> Create(void* data, uint64_t size = 0);
+	static Ref<VulkanIndexBuffer> Create(void* data, uint64_t size = 0, VulkanUploadBatch* batch = nullptr);
 
 	VkBuffer GetVulkanBuffer() const { return m_IndexBuffer; }
 
@@ -17,10 +17,8 @@ public:
 private:
 	uint64_t m_Size = 0;
 
-	Buffer m_LocalData;
-
 	VkBuffer m_IndexBuffer = nullptr;
-	VkDeviceMemory m_IndexBufferMemory = nullptr;
+	VulkanAllocation m_IndexBufferAllocation;
 
 };
 
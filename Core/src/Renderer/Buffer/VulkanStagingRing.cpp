@@ -0,0 +1,245 @@
+#include "pch.h"
+#include "VulkanStagingRing.h"
+
+#include "Renderer/VulkanUploadBatch.h"
+
+#include <chrono>
+
+namespace Utils {
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// 等待其他线程Retire的上限，超过时认为暂存区间被遗漏或线程间互相等待
+	static constexpr auto s_RetireTimeout = std::chrono::seconds(10);
+}
+
+VulkanStagingRing::VulkanStagingRing(VkDevice device, VulkanAllocator& allocator, VkDeviceSize size)
+	: m_Device(device), m_Allocator(allocator), m_Size(size)
+{
+	// 暂存环在VulkanDevice构造期间创建，不能通过VulkanContext访问设备
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	VK_CHECK_RESULT(vkCreateBuffer(device, &bufferInfo, nullptr, &m_Buffer));
+
+	m_Allocation = m_Allocator.AllocateBuffer(m_Buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	CORE_ASSERT(m_Allocation.MappedData, "Staging ring memory is not host visible!");
+}
+
+VulkanStagingRing::~VulkanStagingRing()
+{
+}
+
+void VulkanStagingRing::Destroy()
+{
+	std::scoped_lock lock(m_Mutex);
+
+	m_Pending.clear();
+	for (auto& dedicated : m_DedicatedBuffers)
+		m_Allocator.DestroyBuffer(dedicated.Buffer, dedicated.Allocation);
+	m_DedicatedBuffers.clear();
+	m_Allocator.DestroyBuffer(m_Buffer, m_Allocation);
+	m_Buffer = nullptr;
+}
+
+StagingRegion VulkanStagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+	std::unique_lock lock(m_Mutex);
+
+	Reclaim(false, lock);
+
+	if (size > m_Size)
+		return AllocateDedicated(size);
+
+	uint64_t start = 0;
+	while (true)
+	{
+		// 环空闲时从下一个环起点开始，整个环都可用于这次分配
+		if (m_Pending.empty())
+		{
+			m_Head = (m_Head + m_Size - 1) / m_Size * m_Size;
+			m_Tail = m_Head;
+		}
+
+		start = Utils::AlignUp(m_Head, alignment);
+
+		// 剩余尾部空间不够时回绕到环的起始处
+		uint64_t physical = start % m_Size;
+		if (physical + size > m_Size)
+			start += m_Size - physical;
+
+		if (start + size - m_Tail <= m_Size)
+			break;
+
+		// 没有可回收的空间时不能继续分配，否则会覆盖仍在使用的暂存数据
+		if (!Reclaim(true, lock))
+			throw std::runtime_error("Staging ring is full of allocations that are never retired");
+	}
+
+	m_Head = start + size;
+	m_Pending.push_back({ m_Head, nullptr, false, std::this_thread::get_id() });
+
+	StagingRegion region;
+	region.Buffer = m_Buffer;
+	region.Offset = start % m_Size;
+	region.Size = size;
+	region.Data = (uint8_t*)m_Allocation.MappedData + region.Offset;
+	region.RingEnd = m_Head;
+	return region;
+}
+
+void VulkanStagingRing::Retire(const StagingRegion& region, const Ref<VulkanUploadHandle>& handle)
+{
+	std::unique_lock lock(m_Mutex);
+
+	if (region.Buffer != m_Buffer)
+	{
+		for (auto& dedicated : m_DedicatedBuffers)
+		{
+			if (dedicated.Buffer == region.Buffer)
+			{
+				dedicated.Handle = handle;
+				dedicated.Retired = true;
+				break;
+			}
+		}
+		Reclaim(false, lock);
+		return;
+	}
+
+	// 最近的分配通常在队尾
+	for (auto it = m_Pending.rbegin(); it != m_Pending.rend(); ++it)
+	{
+		if (it->End == region.RingEnd)
+		{
+			it->Handle = handle;
+			it->Retired = true;
+			break;
+		}
+	}
+
+	m_RetireCondition.notify_all();
+	Reclaim(false, lock);
+}
+
+StagingRegion VulkanStagingRing::AllocateDedicated(VkDeviceSize size)
+{
+	DedicatedBuffer dedicated;
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	VK_CHECK_RESULT(vkCreateBuffer(m_Device, &bufferInfo, nullptr, &dedicated.Buffer));
+
+	dedicated.Allocation = m_Allocator.AllocateBuffer(dedicated.Buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	CORE_ASSERT(dedicated.Allocation.MappedData, "Staging memory is not host visible!");
+	m_DedicatedBuffers.push_back(dedicated);
+
+	CORE_WARN("Upload of {0} bytes is larger than the staging ring, using a temporary staging buffer", size);
+
+	StagingRegion region;
+	region.Buffer = dedicated.Buffer;
+	region.Offset = 0;
+	region.Size = size;
+	region.Data = dedicated.Allocation.MappedData;
+	return region;
+}
+
+bool VulkanStagingRing::Reclaim(bool wait, std::unique_lock<std::mutex>& lock)
+{
+	// 查询与等待句柄可能执行完成回调，释放最后一个引用还会回收命令池，这些都在解锁后进行
+	std::vector<Ref<VulkanUploadHandle>> released;
+
+	// 已Retire的临时暂存缓冲区先取出，解锁后检查完成情况，未完成的放回
+	std::vector<DedicatedBuffer> retiredBuffers;
+	std::erase_if(m_DedicatedBuffers, [&retiredBuffers](DedicatedBuffer& dedicated)
+	{
+		if (!dedicated.Retired)
+			return false;
+		retiredBuffers.push_back(std::move(dedicated));
+		return true;
+	});
+	if (!retiredBuffers.empty())
+	{
+		lock.unlock();
+		std::erase_if(retiredBuffers, [this, &released](DedicatedBuffer& dedicated)
+		{
+			if (dedicated.Handle && !dedicated.Handle->IsComplete())
+				return false;
+			m_Allocator.DestroyBuffer(dedicated.Buffer, dedicated.Allocation);
+			released.push_back(std::move(dedicated.Handle));
+			return true;
+		});
+		lock.lock();
+		m_DedicatedBuffers.insert(m_DedicatedBuffers.end(), retiredBuffers.begin(), retiredBuffers.end());
+	}
+
+	bool reclaimed = false;
+
+	// 空间只能按分配顺序回收
+	while (!m_Pending.empty())
+	{
+		PendingRegion& front = m_Pending.front();
+		uint64_t end = front.End;
+		if (!front.Retired)
+		{
+			if (!wait || reclaimed)
+				break;
+
+			// 本线程自己的区间在分配返回之前不可能被Retire，等待只会死锁
+			if (front.Owner == std::this_thread::get_id())
+				break;
+
+			// 其他线程的批次仍在记录，等它提交后Retire
+			bool retired = m_RetireCondition.wait_for(lock, Utils::s_RetireTimeout, [this, end]()
+			{
+				return m_Pending.empty() || m_Pending.front().End != end || m_Pending.front().Retired;
+			});
+			if (!retired)
+				break;
+			continue;
+		}
+
+		if (front.Handle)
+		{
+			Ref<VulkanUploadHandle> handle = front.Handle;
+			bool blocking = wait && !reclaimed;
+
+			lock.unlock();
+			if (blocking)
+				handle->Wait();
+			bool complete = handle->IsComplete();
+			lock.lock();
+
+			released.push_back(std::move(handle));
+			if (!complete)
+				break;
+			// 解锁期间其他线程可能已经回收了这个区间
+			if (m_Pending.empty() || m_Pending.front().End != end)
+				continue;
+			released.push_back(std::move(m_Pending.front().Handle));
+		}
+
+		m_Tail = end;
+		m_Pending.pop_front();
+		reclaimed = true;
+	}
+
+	if (m_Pending.empty())
+		m_Tail = m_Head;
+
+	if (!released.empty())
+	{
+		lock.unlock();
+		released.clear();
+		lock.lock();
+	}
+
+	return reclaimed;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "Renderer/Vulkan.h"
+#include "Renderer/VulkanAllocator.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+class VulkanUploadHandle;
+
+// 暂存环中的一段区间，Data可直接写入
+struct StagingRegion
+{
+	VkBuffer Buffer = nullptr;
+	VkDeviceSize Offset = 0;
+	VkDeviceSize Size = 0;
+	void* Data = nullptr;
+
+	uint64_t RingEnd = 0;		// 环内部使用的虚拟结束位置
+};
+
+// 常驻映射的上传暂存环形缓冲区
+// 上传直接写入环中，提交拷贝命令后调用Retire(region, handle)把区间与该次提交关联，
+// 提交完成后空间按分配顺序被回收。空间不足时会等待最旧的一次提交完成，
+// 最旧的区间尚未Retire时等待其他线程Retire；超过环大小的上传使用单独的临时暂存缓冲区
+class VulkanStagingRing
+{
+public:
+	VulkanStagingRing(VkDevice device, VulkanAllocator& allocator, VkDeviceSize size);
+	~VulkanStagingRing();
+
+	void Destroy();
+
+	StagingRegion Allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+	// 将区间与上传句柄关联，句柄为空表示对应的拷贝已经完成
+	void Retire(const StagingRegion& region, const Ref<VulkanUploadHandle>& handle);
+
+	VkBuffer GetBuffer() const { return m_Buffer; }
+	VkDeviceSize GetSize() const { return m_Size; }
+private:
+	// wait为true时阻塞等待最旧的一次提交；lock为持有m_Mutex的锁，等待与释放句柄期间会暂时解锁
+	bool Reclaim(bool wait, std::unique_lock<std::mutex>& lock);
+	StagingRegion AllocateDedicated(VkDeviceSize size);
+private:
+	struct PendingRegion
+	{
+		uint64_t End = 0;
+		Ref<VulkanUploadHandle> Handle;
+		bool Retired = false;
+		std::thread::id Owner;
+	};
+
+	// 超过环大小的上传单独分配的暂存缓冲区，对应的提交完成后销毁
+	struct DedicatedBuffer
+	{
+		VkBuffer Buffer = nullptr;
+		VulkanAllocation Allocation;
+		Ref<VulkanUploadHandle> Handle;
+		bool Retired = false;
+	};
+
+	VkDevice m_Device = nullptr;
+	VulkanAllocator& m_Allocator;
+
+	VkBuffer m_Buffer = nullptr;
+	VulkanAllocation m_Allocation;
+	VkDeviceSize m_Size = 0;
+
+	// 虚拟偏移单调递增，物理偏移为对m_Size取模
+	uint64_t m_Head = 0;		// 下一次分配的位置
+	uint64_t m_Tail = 0;		// 最旧的仍在使用的位置
+	std::deque<PendingRegion> m_Pending;
+	std::vector<DedicatedBuffer> m_DedicatedBuffers;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_RetireCondition;
+};
@@ -4,16 +4,18 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "Buffer.h"
+#include "Renderer/VulkanFrameContext.h"
 
+// 每帧不变的数据，每个物体的变换通过推送常量传入
 struct UniformBufferObject
 {
-    glm::mat4 model;
     glm::mat4 view;
     glm::mat4 proj;
 };
 
-class VulkanUniformBuffer : VulkanBuffer
+// 每帧的uniform数据写入当前帧上下文的uniform区间
+// 描述符集绑定的是UNIFORM_BUFFER_DYNAMIC，每帧只需更换动态偏移
+class VulkanUniformBuffer
 {
 public:
     VulkanUniformBuffer();
@@ -21,12 +23,11 @@ public:
 
     static Ref<VulkanUniformBuffer> Create();
 
-    std::vector<VkBuffer> GetVulkanBuffer() const { return m_UniformBuffers; }
+    // 写入本帧的视图与投影矩阵，返回绑定描述符集时使用的动态偏移
+    uint32_t Update(VulkanFrameContext& frame);
 
-    void UpdateUniformBuffer(uint32_t currentImage);
+    // 描述符集中的缓冲区范围，偏移固定为0，只在该帧内有效
+    VkDescriptorBufferInfo GetDescriptorBufferInfo() const;
 private:
-    std::vector<VkBuffer> m_UniformBuffers;
-    std::vector<VkDeviceMemory> m_UniformBuffersMemory;
-    std::vector<void*> m_UniformBuffersMapped;
+    VulkanFrameContext* m_Frame = nullptr;
 };
-
@@ -3,19 +3,10 @@
 
 #include "Renderer/VulkanContext.h"
 
-VulkanVertexBuffer::VulkanVertexBuffer(void* data, uint64_t size)
+VulkanVertexBuffer::VulkanVertexBuffer(void* data, uint64_t size, VulkanUploadBatch* batch)
 {
-	auto device = VulkanContext::Get()->GetCurrentDevice();
-
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-	Allocate(data, size, stagingBufferMemory);
-	CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_VertexBuffer, m_VertexBufferMemory);
-	CopyBuffer(stagingBuffer, m_VertexBuffer, size);
-
-	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingBufferMemory, nullptr);
+	CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_VertexBuffer, m_VertexBufferAllocation);
+	Upload(m_VertexBuffer, data, size, 0, batch);
 }
 
 VulkanVertexBuffer::~VulkanVertexBuffer()
@@ -30,11 +21,10 @@ void VulkanVertexBuffer::Shutdown()
 	// 确保设备空闲，避免缓冲区仍在使用时被销毁
 	vkDeviceWaitIdle(device);
 
-	vkDestroyBuffer(device, m_VertexBuffer, nullptr);
-	vkFreeMemory(device, m_VertexBufferMemory, nullptr);
+	DestroyBuffer(m_VertexBuffer, m_VertexBufferAllocation);
 }
 
-Ref<VulkanVertexBuffer> VulkanVertexBuffer::Create(void* data, uint64_t size)
+Ref<VulkanVertexBuffer> VulkanVertexBuffer::Create(void* data, uint64_t size, VulkanUploadBatch* batch)
 {
-	return CreateRef<VulkanVertexBuffer>(data, size);
+	return CreateRef<VulkanVertexBuffer>(data, size, batch);
 }
@@ -6,14 +6,14 @@
 class VulkanVertexBuffer : public VulkanBuffer
 {
 public:
-    VulkanVertexBuffer(void* data, uint64_t size);
+    VulkanVertexBuffer(void* data, uint64_t size, VulkanUploadBatch* batch = nullptr);
     ~VulkanVertexBuffer();
 
-    static Ref<VulkanVertexBuffer> Create(void* data, uint64_t size);
+    static Ref<VulkanVertexBuffer> Create(void* data, uint64_t size, VulkanUploadBatch* batch = nullptr);
     void Shutdown();
 
     virtual VkBuffer GetVulkanBuffer() const { return m_VertexBuffer; }
 private:
     VkBuffer m_VertexBuffer = nullptr;
-    VkDeviceMemory m_VertexBufferMemory = nullptr;
+    VulkanAllocation m_VertexBufferAllocation;
 };
\ No newline at end of file
@@ -2,7 +2,257 @@
 #include "DescriptorSetManager.h"
 
 #include "VulkanContext.h"
+#include "VulkanDescriptorSetLayoutCache.h"
 
-DescriptorSetManager::DescriptorSetManager()
+namespace Utils {
+
+    // 每个集合平均需要的各类描述符数量，乘以池的集合数得到池的初始大小
+    struct DescriptorPoolRatio
+    {
+        VkDescriptorType Type;
+        float Ratio;
+    };
+
+    static const DescriptorPoolRatio s_DescriptorPoolRatios[] = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2.0f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2.0f },
+        { VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0.5f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 0.5f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 0.5f },
+        { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f },
+    };
+
+}
+
+DescriptorPoolChain::DescriptorPoolChain(VkDevice device, VulkanDescriptorSetLayoutCache& layoutCache, uint32_t setsPerPool, VkDescriptorPoolCreateFlags flags)
+    : m_Device(device), m_LayoutCache(layoutCache), m_SetsPerPool(std::max(setsPerPool, 1u)), m_Flags(flags)
+{
+    for (const auto& ratio : Utils::s_DescriptorPoolRatios)
+        m_PoolSizes.push_back({ ratio.Type, std::max(static_cast<uint32_t>(ratio.Ratio * m_SetsPerPool), 1u) });
+}
+
+DescriptorPoolChain::~DescriptorPoolChain()
+{
+}
+
+void DescriptorPoolChain::Destroy()
+{
+    std::scoped_lock lock(m_Mutex);
+
+    for (auto& [pool, liveCount] : m_UsedPools)
+        vkDestroyDescriptorPool(m_Device, pool, nullptr);
+    for (auto pool : m_FreePools)
+        vkDestroyDescriptorPool(m_Device, pool, nullptr);
+
+    m_UsedPools.clear();
+    m_FreePools.clear();
+    m_OutdatedPools.clear();
+    m_CurrentPool = nullptr;
+}
+
+VkDescriptorSet DescriptorPoolChain::Allocate(VkDescriptorSetLayout layout, VkDescriptorPool* outPool)
+{
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    std::scoped_lock lock(m_Mutex);
+
+    if (!m_CurrentPool)
+        m_CurrentPool = AcquirePool();
+
+    VkDescriptorSet descriptorSet = nullptr;
+    allocInfo.descriptorPool = m_CurrentPool;
+    VkResult result = vkAllocateDescriptorSets(m_Device, &allocInfo, &descriptorSet);
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+    {
+        // 已满的池留在m_UsedPools中直到重置；换一个空池后只会因布局本身超过池大小而失败
+        m_CurrentPool = AcquirePool();
+        allocInfo.descriptorPool = m_CurrentPool;
+        result = vkAllocateDescriptorSets(m_Device, &allocInfo, &descriptorSet);
+    }
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+    {
+        // 按布局的实际需要扩大池，刚取得的空池没有分配过集合，放回空闲列表或销毁
+        GrowPoolSizes(layout);
+        if (m_UsedPools[m_CurrentPool] == 0)
+        {
+            m_UsedPools.erase(m_CurrentPool);
+            RecyclePool(m_CurrentPool);
+        }
+        m_CurrentPool = AcquirePool();
+        allocInfo.descriptorPool = m_CurrentPool;
+        result = vkAllocateDescriptorSets(m_Device, &allocInfo, &descriptorSet);
+    }
+    VK_CHECK_RESULT(result);
+
+    m_UsedPools[m_CurrentPool]++;
+    if (outPool)
+        *outPool = m_CurrentPool;
+    return descriptorSet;
+}
+
+void DescriptorPoolChain::Free(VkDescriptorSet descriptorSet, VkDescriptorPool pool)
+{
+    CORE_ASSERT(m_Flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, "Descriptor pool chain does not support freeing individual sets!");
+
+    std::scoped_lock lock(m_Mutex);
+    VK_CHECK_RESULT(vkFreeDescriptorSets(m_Device, pool, 1, &descriptorSet));
+
+    // 已满的池清空后重置回收，避免碎片化的池一直占用
+    auto it = m_UsedPools.find(pool);
+    CORE_ASSERT(it != m_UsedPools.end(), "Descriptor set was not allocated from this pool chain!");
+    if (--it->second == 0 && pool != m_CurrentPool)
+    {
+        m_UsedPools.erase(it);
+        RecyclePool(pool);
+    }
+}
+
+void DescriptorPoolChain::Reset()
+{
+    std::scoped_lock lock(m_Mutex);
+
+    for (auto& [pool, liveCount] : m_UsedPools)
+        RecyclePool(pool);
+    m_UsedPools.clear();
+    m_CurrentPool = nullptr;
+}
+
+uint32_t DescriptorPoolChain::GetPoolCount() const
 {
-}
\ No newline at end of file
+    std::scoped_lock lock(m_Mutex);
+    return static_cast<uint32_t>(m_UsedPools.size() + m_FreePools.size());
+}
+
+VkDescriptorPool DescriptorPoolChain::AcquirePool()
+{
+    VkDescriptorPool pool = nullptr;
+    if (!m_FreePools.empty())
+    {
+        pool = m_FreePools.back();
+        m_FreePools.pop_back();
+    }
+    else
+    {
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = m_Flags;
+        poolInfo.maxSets = m_SetsPerPool;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(m_PoolSizes.size());
+        poolInfo.pPoolSizes = m_PoolSizes.data();
+        VK_CHECK_RESULT(vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &pool));
+    }
+
+    m_UsedPools.emplace(pool, 0);
+    return pool;
+}
+
+void DescriptorPoolChain::GrowPoolSizes(VkDescriptorSetLayout layout)
+{
+    std::vector<VkDescriptorPoolSize> counts = m_LayoutCache.GetDescriptorCounts(layout);
+    CORE_ASSERT(!counts.empty(), "Descriptor set layout was not created by the layout cache, pool sizes cannot be derived from it!");
+
+    for (const auto& count : counts)
+    {
+        uint32_t required = count.descriptorCount * m_SetsPerPool;
+        auto it = std::find_if(m_PoolSizes.begin(), m_PoolSizes.end(), [&count](const VkDescriptorPoolSize& size) { return size.type == count.type; });
+        if (it == m_PoolSizes.end())
+            m_PoolSizes.push_back({ count.type, required });
+        else
+            it->descriptorCount = std::max(it->descriptorCount, required);
+    }
+
+    // 之前的池都比新的池小：空闲的直接销毁，使用中的在空闲后销毁
+    for (auto pool : m_FreePools)
+        vkDestroyDescriptorPool(m_Device, pool, nullptr);
+    m_FreePools.clear();
+    for (auto& [pool, liveCount] : m_UsedPools)
+        m_OutdatedPools.insert(pool);
+
+    CORE_WARN("Descriptor set layout does not fit in an empty pool, growing descriptor pools");
+}
+
+void DescriptorPoolChain::RecyclePool(VkDescriptorPool pool)
+{
+    if (m_OutdatedPools.erase(pool))
+    {
+        vkDestroyDescriptorPool(m_Device, pool, nullptr);
+        return;
+    }
+
+    VK_CHECK_RESULT(vkResetDescriptorPool(m_Device, pool, 0));
+    m_FreePools.push_back(pool);
+}
+
+DescriptorSetManager::DescriptorSetManager(VkDevice device, VulkanDescriptorSetLayoutCache& layoutCache, uint32_t framesInFlight, uint32_t setsPerPool)
+    : m_Device(device)
+{
+    // 临时池只整体重置，不需要FREE_DESCRIPTOR_SET_BIT
+    for (uint32_t i = 0; i < framesInFlight; i++)
+        m_FrameChains.push_back(CreateScope<DescriptorPoolChain>(m_Device, layoutCache, setsPerPool));
+
+    m_PersistentChain = CreateScope<DescriptorPoolChain>(m_Device, layoutCache, setsPerPool, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+}
+
+DescriptorSetManager::~DescriptorSetManager()
+{
+}
+
+void DescriptorSetManager::Destroy()
+{
+    uint32_t transientPoolCount = 0;
+    for (auto& chain : m_FrameChains)
+    {
+        transientPoolCount += chain->GetPoolCount();
+        chain->Destroy();
+    }
+    m_FrameChains.clear();
+
+    CORE_INFO("DescriptorSetManager: {0} transient pools, {1} persistent pools, {2} persistent sets alive",
+        transientPoolCount, m_PersistentChain->GetPoolCount(), m_PersistentSets.size());
+
+    m_PersistentChain->Destroy();
+    m_PersistentChain.reset();
+    m_PersistentSets.clear();
+}
+
+void DescriptorSetManager::ResetFrame(uint32_t frameIndex)
+{
+    m_FrameChains[frameIndex]->Reset();
+}
+
+VkDescriptorSet DescriptorSetManager::AllocateTransient(uint32_t frameIndex, VkDescriptorSetLayout layout)
+{
+    return m_FrameChains[frameIndex]->Allocate(layout);
+}
+
+VkDescriptorSet DescriptorSetManager::AllocatePersistent(VkDescriptorSetLayout layout)
+{
+    VkDescriptorPool pool = nullptr;
+    VkDescriptorSet descriptorSet = m_PersistentChain->Allocate(layout, &pool);
+
+    std::scoped_lock lock(m_PersistentMutex);
+    m_PersistentSets[descriptorSet] = pool;
+    return descriptorSet;
+}
+
+void DescriptorSetManager::FreePersistent(VkDescriptorSet descriptorSet)
+{
+    VkDescriptorPool pool = nullptr;
+    {
+        std::scoped_lock lock(m_PersistentMutex);
+        auto it = m_PersistentSets.find(descriptorSet);
+        CORE_ASSERT(it != m_PersistentSets.end(), "Descriptor set was not allocated as persistent!");
+        pool = it->second;
+        m_PersistentSets.erase(it);
+    }
+
+    m_PersistentChain->Free(descriptorSet, pool);
+}
@@ -1,13 +1,81 @@
 #pragma once
 #include "Vulkan.h"
-#include <glm/glm.hpp>
 
-class DescriptorSetManager
+#include <mutex>
+#include <unordered_set>
+
+class VulkanDescriptorSetLayoutCache;
+
+// 描述符池链
+// 当前池耗尽（OUT_OF_POOL_MEMORY/FRAGMENTED_POOL）时换用空闲池或新建一个池后重试。
+// 布局在空池中仍放不下时，按它的描述符数量（来自布局缓存中反射得到的绑定）扩大之后新建的池，
+// 较小的旧池在空闲后销毁，因此分配不会因为池的大小而失败。池的数量只增不减，Reset()后全部回到空闲列表供下次使用
+class DescriptorPoolChain
 {
 public:
-    DescriptorSetManager();
+    DescriptorPoolChain(VkDevice device, VulkanDescriptorSetLayoutCache& layoutCache, uint32_t setsPerPool, VkDescriptorPoolCreateFlags flags = 0);
+    ~DescriptorPoolChain();
+
+    void Destroy();
+
+    // 线程安全；outPool返回集合所在的池，释放时需要
+    VkDescriptorSet Allocate(VkDescriptorSetLayout layout, VkDescriptorPool* outPool = nullptr);
+    // 线程安全，只用于FREE_DESCRIPTOR_SET_BIT创建的池链；池中的集合全部释放后整体回收
+    void Free(VkDescriptorSet descriptorSet, VkDescriptorPool pool);
+    // 重置所有池，之前分配的集合全部失效
+    void Reset();
 
+    uint32_t GetPoolCount() const;
 private:
-    VkDescriptorPool m_DescriptorPool = nullptr;
+    VkDescriptorPool AcquirePool();
+    // 扩大之后新建的池，使其至少能容纳m_SetsPerPool个该布局的集合
+    void GrowPoolSizes(VkDescriptorSetLayout layout);
+    // 空闲的池回到空闲列表，比当前池大小小的池直接销毁
+    void RecyclePool(VkDescriptorPool pool);
+private:
+    VkDevice m_Device = nullptr;
+    VulkanDescriptorSetLayoutCache& m_LayoutCache;
+    uint32_t m_SetsPerPool = 0;
+    VkDescriptorPoolCreateFlags m_Flags = 0;
+
+    // 新建池的大小，初始按Utils::s_DescriptorPoolRatios估算
+    std::vector<VkDescriptorPoolSize> m_PoolSizes;
+    // 扩大池大小之前创建、仍在使用的池
+    std::unordered_set<VkDescriptorPool> m_OutdatedPools;
+
+    VkDescriptorPool m_CurrentPool = nullptr;
+    // 当前池与已满的池 -> 池中存活的集合数量
+    std::unordered_map<VkDescriptorPool, uint32_t> m_UsedPools;
+    std::vector<VkDescriptorPool> m_FreePools;
+    mutable std::mutex m_Mutex;
 };
 
+// 描述符集分配
+// 临时集合来自每个飞行帧各自的池链，该帧的fence等待完成后整体重置；
+// 持久集合来自单独的池链，逐个释放。两者都不会因为池耗尽而失败
+class DescriptorSetManager
+{
+public:
+    DescriptorSetManager(VkDevice device, VulkanDescriptorSetLayoutCache& layoutCache, uint32_t framesInFlight, uint32_t setsPerPool);
+    ~DescriptorSetManager();
+
+    void Destroy();
+
+    // 必须在frameIndex这一帧的fence等待完成之后调用
+    void ResetFrame(uint32_t frameIndex);
+    // 线程安全，集合在该帧下次重置前有效
+    VkDescriptorSet AllocateTransient(uint32_t frameIndex, VkDescriptorSetLayout layout);
+
+    // 线程安全，集合在FreePersistent()之前一直有效
+    VkDescriptorSet AllocatePersistent(VkDescriptorSetLayout layout);
+    // 调用方需保证GPU不再使用该集合（例如通过VulkanFrameContext::DeferRelease）
+    void FreePersistent(VkDescriptorSet descriptorSet);
+private:
+    VkDevice m_Device = nullptr;
+
+    std::vector<Scope<DescriptorPoolChain>> m_FrameChains;
+
+    Scope<DescriptorPoolChain> m_PersistentChain;
+    std::unordered_map<VkDescriptorSet, VkDescriptorPool> m_PersistentSets;
+    std::mutex m_PersistentMutex;
+};
@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "ShaderLibrary.h"
+
+#include <chrono>
+
+ShaderLibrary::ShaderLibrary()
+{
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+	DisableHotReload();
+}
+
+Ref<VulkanShader> ShaderLibrary::Load(const std::string& name, const std::string& vertShaderPath, const std::string& fragShaderPath)
+{
+	auto shader = CreateRef<VulkanShader>(vertShaderPath, fragShaderPath);
+	Add(name, shader);
+	return shader;
+}
+
+void ShaderLibrary::Add(const std::string& name, const Ref<VulkanShader>& shader)
+{
+	{
+		std::scoped_lock lock(m_Mutex);
+		CORE_ASSERT(m_Shaders.find(name) == m_Shaders.end(), "Shader already exists!");
+		m_Shaders[name] = shader;
+	}
+
+	if (m_FileWatcher)
+		WatchShaderFiles(name, shader);
+}
+
+Ref<VulkanShader> ShaderLibrary::Get(const std::string& name) const
+{
+	std::scoped_lock lock(m_Mutex);
+	auto it = m_Shaders.find(name);
+	CORE_ASSERT(it != m_Shaders.end(), "Shader not found!");
+	return it->second;
+}
+
+bool ShaderLibrary::Exists(const std::string& name) const
+{
+	std::scoped_lock lock(m_Mutex);
+	return m_Shaders.find(name) != m_Shaders.end();
+}
+
+void ShaderLibrary::WaitAll() const
+{
+	std::vector<Ref<VulkanShader>> shaders;
+	{
+		std::scoped_lock lock(m_Mutex);
+		for (const auto& [name, shader] : m_Shaders)
+			shaders.push_back(shader);
+	}
+
+	for (const auto& shader : shaders)
+		shader->GetPipelineShaderStageCreateInfos();
+}
+
+void ShaderLibrary::EnableHotReload(std::chrono::milliseconds pollInterval)
+{
+	if (m_FileWatcher)
+		return;
+
+	m_FileWatcher = CreateScope<FileWatcher>([this](const std::filesystem::path& filepath) { OnFileChanged(filepath); }, pollInterval);
+
+	std::vector<std::pair<std::string, Ref<VulkanShader>>> shaders;
+	{
+		std::scoped_lock lock(m_Mutex);
+		shaders.assign(m_Shaders.begin(), m_Shaders.end());
+	}
+
+	for (const auto& [name, shader] : shaders)
+		WatchShaderFiles(name, shader);
+}
+
+void ShaderLibrary::DisableHotReload()
+{
+	if (!m_FileWatcher)
+		return;
+
+	// 正在进行的重新加载仍会访问m_FileWatcher，先等线程结束再释放
+	m_FileWatcher->Stop();
+	m_FileWatcher.reset();
+}
+
+void ShaderLibrary::AddReloadCallback(const ReloadCallback& callback)
+{
+	std::scoped_lock lock(m_Mutex);
+	m_ReloadCallbacks.push_back(callback);
+}
+
+bool ShaderLibrary::Reload(const std::string& name)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	Ref<VulkanShader> oldShader = Get(name);
+	auto shader = CreateRef<VulkanShader>(oldShader->GetVertShaderPath(), oldShader->GetFragShaderPath());
+
+	// 包含关系可能随修改变化，无论成功与否都重新收集
+	if (m_FileWatcher)
+		WatchShaderFiles(name, shader);
+
+	try
+	{
+		shader->GetPipelineShaderStageCreateInfos();
+	}
+	catch (const std::exception& e)
+	{
+		CORE_ERROR("Failed to reload shader '{0}', keeping the previous version:\n{1}", name, e.what());
+		return false;
+	}
+
+	std::vector<ReloadCallback> callbacks;
+	{
+		std::scoped_lock lock(m_Mutex);
+		m_Shaders[name] = shader;
+		callbacks = m_ReloadCallbacks;
+	}
+
+	for (const auto& callback : callbacks)
+		callback(name, oldShader, shader);
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	float timeMs = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+	CORE_INFO("Shader '{0}' reloaded in {1:.2f} ms", name, timeMs);
+	return true;
+}
+
+void ShaderLibrary::WatchShaderFiles(const std::string& name, const Ref<VulkanShader>& shader)
+{
+	std::vector<std::filesystem::path> files = shader->GetSourceFiles();
+	for (const auto& file : files)
+		m_FileWatcher->Watch(file);
+
+	// 不再被包含的文件保留在监视列表中，变化时找不到依赖它的着色器，不会触发重新加载
+	std::scoped_lock lock(m_Mutex);
+	m_SourceFiles[name] = std::move(files);
+}
+
+void ShaderLibrary::OnFileChanged(const std::filesystem::path& filepath)
+{
+	std::vector<std::string> names;
+	{
+		std::scoped_lock lock(m_Mutex);
+		for (const auto& [name, files] : m_SourceFiles)
+		{
+			if (std::find(files.begin(), files.end(), filepath) != files.end())
+				names.push_back(name);
+		}
+	}
+
+	for (const auto& name : names)
+	{
+		CORE_INFO("'{0}' changed, reloading shader '{1}'", filepath.generic_string(), name);
+		Reload(name);
+	}
+}
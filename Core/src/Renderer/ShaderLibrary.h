@@ -0,0 +1,49 @@
+#pragma once
+
+#include "VulkanShader.h"
+#include "Base/FileWatcher.h"
+
+#include <mutex>
+
+// 按名称管理着色器
+// Load()立即把各阶段交给工作线程编译并返回，着色器在创建管线时才等待编译结果，
+// 因此先集中注册所有着色器可以让编译在多个核心上同时进行
+class ShaderLibrary
+{
+public:
+	// 着色器重新加载成功后在监视线程上调用，oldShader可能仍被飞行中的帧使用
+	using ReloadCallback = std::function<void(const std::string& name, const Ref<VulkanShader>& oldShader, const Ref<VulkanShader>& newShader)>;
+public:
+	ShaderLibrary();
+	~ShaderLibrary();
+
+	Ref<VulkanShader> Load(const std::string& name, const std::string& vertShaderPath, const std::string& fragShaderPath);
+	void Add(const std::string& name, const Ref<VulkanShader>& shader);
+
+	Ref<VulkanShader> Get(const std::string& name) const;
+	bool Exists(const std::string& name) const;
+
+	// 阻塞直到所有着色器编译完成
+	void WaitAll() const;
+
+	// 监视所有着色器的源文件与包含文件，变化后在后台重新编译并替换
+	void EnableHotReload(std::chrono::milliseconds pollInterval);
+	// 停止监视，返回后不会再调用重新加载回调
+	void DisableHotReload();
+	void AddReloadCallback(const ReloadCallback& callback);
+
+	// 重新编译名为name的着色器，阻塞直到编译完成；失败时保留原着色器并返回false
+	// 编译在工作线程上进行，不能在工作线程中调用
+	bool Reload(const std::string& name);
+private:
+	void WatchShaderFiles(const std::string& name, const Ref<VulkanShader>& shader);
+	void OnFileChanged(const std::filesystem::path& filepath);
+private:
+	std::unordered_map<std::string, Ref<VulkanShader>> m_Shaders;
+	// 着色器名称 -> 源文件，用于找出文件变化影响的着色器
+	std::unordered_map<std::string, std::vector<std::filesystem::path>> m_SourceFiles;
+	std::vector<ReloadCallback> m_ReloadCallbacks;
+	mutable std::mutex m_Mutex;
+
+	Scope<FileWatcher> m_FileWatcher;
+};
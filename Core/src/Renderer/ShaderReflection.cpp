@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "ShaderReflection.h"
+
+#include <spirv_cross/spirv_cross.hpp>
+
+namespace Utils {
+
+	static VkFormat GetVertexInputFormat(const spirv_cross::SPIRType& type)
+	{
+		static const VkFormat floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+		static const VkFormat intFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+		static const VkFormat uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+		if (type.vecsize < 1 || type.vecsize > 4 || type.columns != 1)
+			return VK_FORMAT_UNDEFINED;
+
+		switch (type.basetype)
+		{
+			case spirv_cross::SPIRType::Float: return floatFormats[type.vecsize - 1];
+			case spirv_cross::SPIRType::Int:   return intFormats[type.vecsize - 1];
+			case spirv_cross::SPIRType::UInt:  return uintFormats[type.vecsize - 1];
+		}
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	static void AddBindings(ShaderReflection& reflection, const spirv_cross::Compiler& compiler,
+		const spirv_cross::SmallVector<spirv_cross::Resource>& resources, VkDescriptorType descriptorType, VkShaderStageFlagBits stage)
+	{
+		for (const auto& resource : resources)
+		{
+			uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+			uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+			const auto& type = compiler.get_type(resource.type_id);
+
+			VkDescriptorType resolvedType = descriptorType;
+			// 只有帧uniform从帧上下文的uniform区间线性分配，通过动态偏移切换
+			if (descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && set == ShaderReflection::FrameUniformSet && binding == ShaderReflection::FrameUniformBinding)
+				resolvedType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			// 纹素缓冲区在SPIR-V中与图像共用类型，按维度区分
+			if (type.basetype == spirv_cross::SPIRType::Image && type.image.dim == spv::DimBuffer)
+			{
+				if (descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE)
+					resolvedType = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				else if (descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+					resolvedType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+			}
+
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = binding;
+			layoutBinding.descriptorType = resolvedType;
+			// 运行时数组（array[0] == 0）按1计，由使用方按需扩展
+			layoutBinding.descriptorCount = type.array.empty() ? 1 : std::max(type.array[0], 1u);
+			layoutBinding.stageFlags = stage;
+			layoutBinding.pImmutableSamplers = nullptr;
+			reflection.DescriptorSets[set][binding] = layoutBinding;
+		}
+	}
+
+}
+
+ShaderReflection ShaderReflection::Reflect(const std::vector<uint32_t>& spirv, VkShaderStageFlagBits stage)
+{
+	ShaderReflection reflection;
+
+	spirv_cross::Compiler compiler(spirv);
+	spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+	// 帧uniform使用动态uniform缓冲区，一个描述符集即可服务所有飞行帧
+	Utils::AddBindings(reflection, compiler, resources.uniform_buffers, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, stage);
+	Utils::AddBindings(reflection, compiler, resources.storage_buffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stage);
+	Utils::AddBindings(reflection, compiler, resources.sampled_images, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, stage);
+	Utils::AddBindings(reflection, compiler, resources.separate_images, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, stage);
+	Utils::AddBindings(reflection, compiler, resources.separate_samplers, VK_DESCRIPTOR_TYPE_SAMPLER, stage);
+	Utils::AddBindings(reflection, compiler, resources.storage_images, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage);
+	Utils::AddBindings(reflection, compiler, resources.subpass_inputs, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, stage);
+
+	// 推送常量块的范围从第一个成员的偏移开始，不同阶段可以使用同一块的不同部分
+	for (const auto& resource : resources.push_constant_buffers)
+	{
+		const auto& type = compiler.get_type(resource.base_type_id);
+		if (type.member_types.empty())
+			continue;
+
+		uint32_t offset = UINT32_MAX;
+		for (uint32_t i = 0; i < (uint32_t)type.member_types.size(); i++)
+			offset = std::min(offset, compiler.type_struct_member_offset(type, i));
+
+		VkPushConstantRange range{};
+		range.stageFlags = stage;
+		range.offset = offset;
+		range.size = (uint32_t)compiler.get_declared_struct_size(type) - offset;
+		reflection.PushConstantRanges.push_back(range);
+	}
+
+	if (stage == VK_SHADER_STAGE_VERTEX_BIT)
+	{
+		for (const auto& resource : resources.stage_inputs)
+		{
+			const auto& type = compiler.get_type(resource.type_id);
+
+			ShaderVertexInput input;
+			input.Location = compiler.get_decoration(resource.id, spv::DecorationLocation);
+			input.Format = Utils::GetVertexInputFormat(type);
+			input.Size = type.vecsize * (type.width / 8);
+			input.Name = resource.name;
+			CORE_ASSERT(input.Format != VK_FORMAT_UNDEFINED, "Unsupported vertex input type!");
+			reflection.VertexInputs.push_back(input);
+		}
+
+		std::sort(reflection.VertexInputs.begin(), reflection.VertexInputs.end(),
+			[](const ShaderVertexInput& a, const ShaderVertexInput& b) { return a.Location < b.Location; });
+	}
+
+	return reflection;
+}
+
+void ShaderReflection::Merge(const ShaderReflection& other)
+{
+	for (const auto& [set, bindings] : other.DescriptorSets)
+	{
+		for (const auto& [binding, layoutBinding] : bindings)
+		{
+			auto& existing = DescriptorSets[set];
+			auto it = existing.find(binding);
+			if (it == existing.end())
+			{
+				existing[binding] = layoutBinding;
+				continue;
+			}
+
+			CORE_ASSERT(it->second.descriptorType == layoutBinding.descriptorType && it->second.descriptorCount == layoutBinding.descriptorCount,
+				"Shader stages declare different resources at the same set and binding!");
+			it->second.stageFlags |= layoutBinding.stageFlags;
+		}
+	}
+
+	// 范围完全相同时合并阶段，否则各自保留
+	for (const auto& range : other.PushConstantRanges)
+	{
+		auto it = std::find_if(PushConstantRanges.begin(), PushConstantRanges.end(),
+			[&range](const VkPushConstantRange& r) { return r.offset == range.offset && r.size == range.size; });
+		if (it != PushConstantRanges.end())
+			it->stageFlags |= range.stageFlags;
+		else
+			PushConstantRanges.push_back(range);
+	}
+
+	if (!other.VertexInputs.empty())
+		VertexInputs = other.VertexInputs;
+}
+
+std::vector<VkDescriptorSetLayoutBinding> ShaderReflection::GetSetBindings(uint32_t set) const
+{
+	std::vector<VkDescriptorSetLayoutBinding> result;
+
+	auto it = DescriptorSets.find(set);
+	if (it == DescriptorSets.end())
+		return result;
+
+	result.reserve(it->second.size());
+	for (const auto& [binding, layoutBinding] : it->second)
+		result.push_back(layoutBinding);
+	return result;
+}
+
+uint32_t ShaderReflection::FindBinding(uint32_t set, VkDescriptorType type) const
+{
+	auto it = DescriptorSets.find(set);
+	if (it == DescriptorSets.end())
+		return UINT32_MAX;
+
+	for (const auto& [binding, layoutBinding] : it->second)
+	{
+		if (layoutBinding.descriptorType == type)
+			return binding;
+	}
+	return UINT32_MAX;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Vulkan.h"
+
+#include <map>
+
+// 顶点着色器的一个输入
+struct ShaderVertexInput
+{
+	uint32_t Location = 0;
+	VkFormat Format = VK_FORMAT_UNDEFINED;
+	uint32_t Size = 0;
+	std::string Name;
+};
+
+// 从SPIR-V反射得到的资源信息，多个阶段合并后描述整个着色器
+struct ShaderReflection
+{
+	// 帧uniform的位置，反射为UNIFORM_BUFFER_DYNAMIC，其余uniform缓冲区为UNIFORM_BUFFER
+	static constexpr uint32_t FrameUniformSet = 0;
+	static constexpr uint32_t FrameUniformBinding = 0;
+
+	// set -> (binding -> 描述)，std::map保证按编号有序
+	std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> DescriptorSets;
+	std::vector<VkPushConstantRange> PushConstantRanges;
+	// 按location排序，只来自顶点阶段
+	std::vector<ShaderVertexInput> VertexInputs;
+
+	// 反射单个阶段的SPIR-V
+	static ShaderReflection Reflect(const std::vector<uint32_t>& spirv, VkShaderStageFlagBits stage);
+	// 合并另一个阶段，相同的set/binding合并stageFlags
+	void Merge(const ShaderReflection& other);
+
+	uint32_t GetDescriptorSetCount() const { return DescriptorSets.empty() ? 0 : DescriptorSets.rbegin()->first + 1; }
+	// set中的所有绑定，按binding排序；set不存在时为空
+	std::vector<VkDescriptorSetLayoutBinding> GetSetBindings(uint32_t set) const;
+	// set中第一个该类型的绑定编号，不存在时返回UINT32_MAX
+	uint32_t FindBinding(uint32_t set, VkDescriptorType type) const;
+};
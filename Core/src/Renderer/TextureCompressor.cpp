@@ -0,0 +1,206 @@
+#include "pch.h"
+#include "TextureCompressor.h"
+
+#include <climits>
+
+namespace Utils {
+
+	static uint16_t ToRGB565(const uint8_t* color)
+	{
+		return (uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+	}
+
+	static void FromRGB565(uint16_t value, int* color)
+	{
+		int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// 从图像中取出一个4x4块，越界的像素重复边缘
+	static void FetchBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t block[16][4])
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			uint32_t sy = std::min(blockY * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t sx = std::min(blockX * 4 + x, width - 1);
+				memcpy(block[y * 4 + x], rgba + ((size_t)sy * width + sx) * 4, 4);
+			}
+		}
+	}
+
+	// 颜色块：两个RGB565端点与16个2位索引，始终使用四色模式
+	static void EncodeColorBlock(const uint8_t block[16][4], uint8_t* out)
+	{
+		uint8_t minColor[3] = { 255, 255, 255 };
+		uint8_t maxColor[3] = { 0, 0, 0 };
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				minColor[c] = std::min(minColor[c], block[i][c]);
+				maxColor[c] = std::max(maxColor[c], block[i][c]);
+			}
+		}
+
+		// 包围盒向内收缩1/16，减少端点处的量化误差
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			int inset = (maxColor[c] - minColor[c]) >> 4;
+			minColor[c] = (uint8_t)std::min(minColor[c] + inset, 255);
+			maxColor[c] = (uint8_t)std::max(maxColor[c] - inset, 0);
+		}
+
+		uint16_t color0 = ToRGB565(maxColor);
+		uint16_t color1 = ToRGB565(minColor);
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][3];
+			FromRGB565(color0, palette[0]);
+			FromRGB565(color1, palette[1]);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t best = 0;
+				int bestDistance = INT_MAX;
+				for (uint32_t p = 0; p < 4; p++)
+				{
+					int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+					int distance = dr * dr + dg * dg + db * db;
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						best = p;
+					}
+				}
+				indices |= best << (i * 2);
+			}
+		}
+
+		memcpy(out, &color0, 2);
+		memcpy(out + 2, &color1, 2);
+		memcpy(out + 4, &indices, 4);
+	}
+
+	// 单通道块（BC4/BC3 alpha）：两个8位端点与16个3位索引，使用八值模式
+	static void EncodeChannelBlock(const uint8_t block[16][4], uint32_t channel, uint8_t* out)
+	{
+		uint8_t minValue = 255, maxValue = 0;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			minValue = std::min(minValue, block[i][channel]);
+			maxValue = std::max(maxValue, block[i][channel]);
+		}
+
+		uint64_t indices = 0;
+		if (maxValue != minValue)
+		{
+			// 索引0为max，1为min，2-7从max向min插值
+			int palette[8];
+			palette[0] = maxValue;
+			palette[1] = minValue;
+			for (int p = 1; p < 7; p++)
+				palette[p + 1] = ((7 - p) * maxValue + p * minValue) / 7;
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint64_t best = 0;
+				int bestDistance = INT_MAX;
+				for (uint32_t p = 0; p < 8; p++)
+				{
+					int distance = std::abs(block[i][channel] - palette[p]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						best = p;
+					}
+				}
+				indices |= best << (i * 3);
+			}
+		}
+
+		out[0] = maxValue;
+		out[1] = minValue;
+		memcpy(out + 2, &indices, 6);
+	}
+
+}
+
+bool TextureCompressor::IsCompressedFormat(VkFormat format)
+{
+	return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+}
+
+uint64_t TextureCompressor::GetLevelSize(VkFormat format, uint32_t width, uint32_t height)
+{
+	if (!IsCompressedFormat(format))
+		return (uint64_t)width * height * 4;
+
+	uint64_t blockCount = (uint64_t)((width + 3) / 4) * ((height + 3) / 4);
+	switch (format)
+	{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			return blockCount * 8;
+	}
+	return blockCount * 16;
+}
+
+void TextureCompressor::Compress(VkFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out)
+{
+	if (!IsCompressedFormat(format))
+	{
+		memcpy(out, rgba, GetLevelSize(format, width, height));
+		return;
+	}
+
+	uint32_t blocksX = (width + 3) / 4;
+	uint32_t blocksY = (height + 3) / 4;
+	uint64_t blockSize = GetLevelSize(format, 4, 4);
+
+	uint8_t block[16][4];
+	for (uint32_t by = 0; by < blocksY; by++)
+	{
+		for (uint32_t bx = 0; bx < blocksX; bx++)
+		{
+			Utils::FetchBlock(rgba, width, height, bx, by, block);
+			uint8_t* dst = out + ((uint64_t)by * blocksX + bx) * blockSize;
+
+			switch (format)
+			{
+				case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+				case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+					Utils::EncodeColorBlock(block, dst);
+					break;
+				case VK_FORMAT_BC3_UNORM_BLOCK:
+				case VK_FORMAT_BC3_SRGB_BLOCK:
+					Utils::EncodeChannelBlock(block, 3, dst);
+					Utils::EncodeColorBlock(block, dst + 8);
+					break;
+				case VK_FORMAT_BC5_UNORM_BLOCK:
+					Utils::EncodeChannelBlock(block, 0, dst);
+					Utils::EncodeChannelBlock(block, 1, dst + 8);
+					break;
+				default:
+					CORE_ASSERT(false, "Unsupported block compression format!");
+					return;
+			}
+		}
+	}
+}
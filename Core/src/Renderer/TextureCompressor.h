@@ -0,0 +1,16 @@
+#pragma once
+#include "Vulkan.h"
+
+// BC块压缩
+// 输入为紧密排列的RGBA8像素，宽高不必是4的倍数，边缘块重复最后一行/列。
+// 编码使用包围盒端点，速度优先，质量接近实时压缩器
+class TextureCompressor
+{
+public:
+	static bool IsCompressedFormat(VkFormat format);
+	// 一个级别压缩后或未压缩时的字节数
+	static uint64_t GetLevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+	// 支持BC1、BC3、BC5（sRGB与UNORM）以及R8G8B8A8（直接拷贝）
+	static void Compress(VkFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out);
+};
@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "TextureLoader.h"
+
+#include "Application.h"
+#include "VulkanContext.h"
+
+#include <chrono>
+
+TextureLoader::~TextureLoader()
+{
+	// 解码任务写入句柄持有的future，销毁前等待它们结束；未上传的数据随句柄释放
+	for (auto& handle : m_Pending)
+	{
+		if (handle->m_Decode.valid())
+			handle->m_Decode.wait();
+	}
+
+	// 上传句柄析构时等待各自的fence
+	m_Uploads.clear();
+}
+
+Ref<TextureLoadHandle> TextureLoader::Load(const TextureSpecification& specification, const std::filesystem::path& filepath)
+{
+	Ref<TextureLoadHandle> handle = CreateRef<TextureLoadHandle>();
+	handle->m_Filepath = filepath;
+	handle->m_Decode = Application::Get().GetThreadPool().Submit([specification, filepath]()
+	{
+		return VulkanTexture::LoadData(specification, filepath);
+	});
+
+	m_Pending.push_back(handle);
+	return handle;
+}
+
+void TextureLoader::Update()
+{
+	m_Uploads.erase(std::remove_if(m_Uploads.begin(), m_Uploads.end(),
+		[](const Ref<VulkanUploadHandle>& upload) { return upload->IsComplete(); }), m_Uploads.end());
+
+	if (m_Pending.empty())
+		return;
+
+	uint64_t budget = VulkanContext::Get()->GetConfig().TextureUploadBudgetPerFrame;
+	uint64_t uploadedBytes = 0;
+
+	VulkanUploadBatch batch;
+	for (auto it = m_Pending.begin(); it != m_Pending.end();)
+	{
+		TextureLoadHandle& handle = **it;
+		if (!handle.m_Data)
+		{
+			if (handle.m_Decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+
+			try
+			{
+				handle.m_Data = handle.m_Decode.get();
+			}
+			catch (const std::exception& e)
+			{
+				CORE_ERROR("Failed to load texture '{0}': {1}", handle.m_Filepath.string(), e.what());
+				handle.m_Ready = true;
+				it = m_Pending.erase(it);
+				continue;
+			}
+		}
+
+		// 超出本帧预算时停止，剩下的按加载顺序留到之后的帧
+		uint64_t size = handle.m_Data->Baked ? handle.m_Data->BakedData.DataSize : handle.m_Data->Pixels.Size;
+		if (uploadedBytes > 0 && uploadedBytes + size > budget)
+			break;
+
+		handle.m_Texture = VulkanTexture::Create(*handle.m_Data, &batch);
+		handle.m_Data.reset();
+		handle.m_Ready = true;
+		uploadedBytes += size;
+		it = m_Pending.erase(it);
+	}
+
+	if (!batch.IsEmpty())
+		m_Uploads.push_back(batch.Submit());
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "VulkanTexture.h"
+#include "VulkanUploadBatch.h"
+
+#include <future>
+
+// 一次异步纹理加载，TextureLoader::Update()完成上传后就绪
+class TextureLoadHandle
+{
+public:
+	bool IsReady() const { return m_Ready; }
+	// 就绪后有效，解码失败时为空
+	const Ref<VulkanTexture>& GetTexture() const { return m_Texture; }
+	const std::filesystem::path& GetFilepath() const { return m_Filepath; }
+private:
+	std::filesystem::path m_Filepath;
+	std::future<Scope<TextureData>> m_Decode;
+	// 解码完成但受上传预算限制尚未上传的数据
+	Scope<TextureData> m_Data;
+	Ref<VulkanTexture> m_Texture;
+	bool m_Ready = false;
+
+	friend class TextureLoader;
+};
+
+// 异步纹理加载
+// 读取纹理缓存、烘焙或解码图像在工作线程上并行进行，渲染线程每帧调用Update()，
+// 把已准备好的纹理记录进同一个上传批次一次提交，渲染循环不必等待解码
+// 只能在渲染线程上使用
+class TextureLoader
+{
+public:
+	TextureLoader() = default;
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	Ref<TextureLoadHandle> Load(const TextureSpecification& specification, const std::filesystem::path& filepath);
+
+	// 创建并上传已解码的纹理，每帧的上传量受TextureUploadBudgetPerFrame限制
+	// 上传与之后的绘制提交在同一队列上按顺序执行，返回时已就绪的纹理即可用于绘制
+	void Update();
+
+	// 尚未就绪的加载数量
+	uint32_t GetPendingCount() const { return (uint32_t)m_Pending.size(); }
+private:
+	std::vector<Ref<TextureLoadHandle>> m_Pending;
+	// 已提交的上传，完成后释放
+	std::vector<Ref<VulkanUploadHandle>> m_Uploads;
+};
@@ -0,0 +1,143 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+
+#include "VulkanContext.h"
+
+TextureStreamer::TextureStreamer()
+	: m_Budget(VulkanContext::Get()->GetConfig().TextureStreamingBudget)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	// 句柄还可能被暂存环持有，在这里等待完成，让旧图像的释放在设备销毁之前执行
+	for (auto& upload : m_Uploads)
+		upload->Wait();
+	m_Uploads.clear();
+}
+
+void TextureStreamer::Request(const Ref<VulkanTexture>& texture, uint32_t screenSize)
+{
+	if (!texture->IsStreaming())
+		return;
+
+	Entry& entry = m_Entries[texture.get()];
+	if (entry.LastRequestFrame != m_FrameNumber)
+		entry.RequestedSize = 0;
+
+	entry.Texture = texture;
+	entry.RequestedSize = std::max(entry.RequestedSize, screenSize);
+	entry.LastRequestFrame = m_FrameNumber;
+}
+
+void TextureStreamer::Update()
+{
+	m_Uploads.erase(std::remove_if(m_Uploads.begin(), m_Uploads.end(),
+		[](const Ref<VulkanUploadHandle>& upload) { return upload->IsComplete(); }), m_Uploads.end());
+
+	// 已销毁的纹理不再占用预算
+	std::erase_if(m_Entries, [](const auto& pair) { return pair.second.Texture.expired(); });
+
+	m_ResidentSize = 0;
+	for (const auto& [texture, entry] : m_Entries)
+		m_ResidentSize += texture->GetStreamingSize(texture->GetResidentMipLevel());
+
+	const auto& config = VulkanContext::Get()->GetConfig();
+	uint64_t budget = m_Budget;
+
+	// 本帧请求了更高级别的纹理，屏幕上越大越先调入
+	std::vector<std::pair<VulkanTexture*, uint32_t>> requests;
+	for (const auto& [texture, entry] : m_Entries)
+	{
+		if (entry.LastRequestFrame != m_FrameNumber)
+			continue;
+
+		uint32_t mipLevel = texture->GetMipLevelForSize(entry.RequestedSize);
+		if (mipLevel < texture->GetResidentMipLevel())
+			requests.push_back({ texture, entry.RequestedSize });
+	}
+	std::sort(requests.begin(), requests.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+	VulkanUploadBatch batch;
+	uint64_t uploadedBytes = 0;
+	for (const auto& [texture, requestedSize] : requests)
+	{
+		uint32_t residentMip = texture->GetResidentMipLevel();
+		uint64_t residentSize = texture->GetStreamingSize(residentMip);
+		uint32_t mipLevel = texture->GetMipLevelForSize(requestedSize);
+
+		// 超出本帧上传预算时停止，剩下的留到之后的帧
+		uint64_t size = texture->GetStreamingSize(mipLevel) - residentSize;
+		if (uploadedBytes > 0 && uploadedBytes + size > config.TextureUploadBudgetPerFrame)
+			break;
+
+		if (m_ResidentSize + size > budget)
+			m_ResidentSize -= Evict(m_ResidentSize + size - budget, texture, false, batch);
+
+		// 腾出的空间不够时只调入放得下的级别
+		while (mipLevel < residentMip && m_ResidentSize + texture->GetStreamingSize(mipLevel) - residentSize > budget)
+			mipLevel++;
+		if (mipLevel == residentMip)
+			continue;
+
+		size = texture->GetStreamingSize(mipLevel) - residentSize;
+		texture->SetResidentMipLevel(mipLevel, batch);
+		m_ResidentSize += size;
+		uploadedBytes += size;
+	}
+
+	// 预算调低后可能已经超出，先驱逐本帧不需要的级别，仍不够时降低本帧请求的纹理
+	if (m_ResidentSize > budget)
+		m_ResidentSize -= Evict(m_ResidentSize - budget, nullptr, false, batch);
+	if (m_ResidentSize > budget)
+		m_ResidentSize -= Evict(m_ResidentSize - budget, nullptr, true, batch);
+
+	if (!batch.IsEmpty())
+		m_Uploads.push_back(batch.Submit());
+
+	m_FrameNumber++;
+}
+
+uint64_t TextureStreamer::Evict(uint64_t size, VulkanTexture* exclude, bool evictRequested, VulkanUploadBatch& batch)
+{
+	// 通常只驱逐本帧不需要的级别：未请求的纹理按最久未请求的顺序降向mip尾部，本帧请求的纹理只驱逐超出请求的级别
+	// evictRequested时预算已容不下本帧的请求，从屏幕上最小的纹理开始降低，最多降到mip尾部
+	struct Victim
+	{
+		VulkanTexture* Texture;
+		uint32_t MipLevel;
+		uint64_t Priority;
+	};
+
+	std::vector<Victim> victims;
+	for (const auto& [texture, entry] : m_Entries)
+	{
+		if (texture == exclude)
+			continue;
+
+		bool requested = entry.LastRequestFrame == m_FrameNumber;
+		uint32_t mipLevel = texture->GetMipTailLevel();
+		if (requested && !evictRequested)
+			mipLevel = std::min(texture->GetMipLevelForSize(entry.RequestedSize), mipLevel);
+		if (mipLevel > texture->GetResidentMipLevel())
+			victims.push_back({ texture, mipLevel, evictRequested ? entry.RequestedSize : entry.LastRequestFrame });
+	}
+	std::sort(victims.begin(), victims.end(), [](const Victim& a, const Victim& b) { return a.Priority < b.Priority; });
+
+	uint64_t freed = 0;
+	for (const auto& victim : victims)
+	{
+		if (freed >= size)
+			break;
+
+		// 只降低到腾出足够空间为止
+		uint64_t residentSize = victim.Texture->GetStreamingSize(victim.Texture->GetResidentMipLevel());
+		uint32_t mipLevel = victim.Texture->GetResidentMipLevel() + 1;
+		while (mipLevel < victim.MipLevel && freed + residentSize - victim.Texture->GetStreamingSize(mipLevel) < size)
+			mipLevel++;
+
+		freed += residentSize - victim.Texture->GetStreamingSize(mipLevel);
+		victim.Texture->SetResidentMipLevel(mipLevel, batch);
+	}
+	return freed;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "VulkanTexture.h"
+#include "VulkanUploadBatch.h"
+
+// 流式纹理的常驻级别管理
+// 每帧按请求的屏幕尺寸计算各纹理需要的最高级别，在显存预算内调入，同样受每帧上传预算限制；
+// 超出预算时先驱逐最久未被请求的纹理，把它们降向mip尾部；调入不会驱逐本帧请求的级别，
+// 只有预算调低到容不下本帧的请求时才降低它们，mip尾部始终常驻
+// 只能在渲染线程上使用，Update()须在BeginFrame()之后调用
+class TextureStreamer
+{
+public:
+	TextureStreamer();
+	~TextureStreamer();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// 本帧纹理在屏幕上约screenSize像素（较长边），同一帧多次请求取最大值；非流式纹理忽略
+	void Request(const Ref<VulkanTexture>& texture, uint32_t screenSize);
+	void Update();
+
+	// 默认为VulkanConfig::TextureStreamingBudget，调低后下一次Update()驱逐到预算以内
+	void SetBudget(uint64_t budget) { m_Budget = budget; }
+	uint64_t GetBudget() const { return m_Budget; }
+	// 所有流式纹理当前常驻的数据量
+	uint64_t GetResidentSize() const { return m_ResidentSize; }
+private:
+	struct Entry
+	{
+		std::weak_ptr<VulkanTexture> Texture;
+		uint32_t RequestedSize = 0;
+		uint64_t LastRequestFrame = 0;
+	};
+
+	// 从exclude以外的纹理驱逐直到释放至少size字节，返回实际释放的字节数
+	// evictRequested为false时不驱逐本帧请求的级别
+	uint64_t Evict(uint64_t size, VulkanTexture* exclude, bool evictRequested, VulkanUploadBatch& batch);
+private:
+	std::unordered_map<VulkanTexture*, Entry> m_Entries;
+	uint64_t m_FrameNumber = 1;
+	uint64_t m_Budget = 0;
+	uint64_t m_ResidentSize = 0;
+
+	// 已提交的调入与驱逐，完成后释放
+	std::vector<Ref<VulkanUploadHandle>> m_Uploads;
+};
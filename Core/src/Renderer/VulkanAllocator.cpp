@@ -0,0 +1,300 @@
+#include "pch.h"
+#include "VulkanAllocator.h"
+
+#include "VulkanDevice.h"
+
+namespace Utils {
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+// 默认块大小，小显存堆会按比例缩小
+static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+VulkanAllocator::VulkanAllocator(VkDevice device, const Ref<VulkanPhysicalDevice>& physicalDevice)
+	: m_Device(device), m_PhysicalDevice(physicalDevice)
+{
+	m_BufferImageGranularity = m_PhysicalDevice->GetProperties().limits.bufferImageGranularity;
+
+	// 每种内存类型分线性与非线性两个池
+	m_Pools.resize(m_PhysicalDevice->GetMemoryProperties().memoryTypeCount * 2);
+}
+
+VulkanAllocator::~VulkanAllocator()
+{
+}
+
+void VulkanAllocator::Destroy()
+{
+	std::scoped_lock lock(m_Mutex);
+
+	if (m_Stats.AllocationCount > 0)
+		CORE_WARN("VulkanAllocator: {0} allocations still alive on destroy", m_Stats.AllocationCount);
+
+	for (auto& pool : m_Pools)
+	{
+		for (auto& block : pool.Blocks)
+			DestroyBlock(*block);
+		pool.Blocks.clear();
+	}
+	m_BlockLookup.clear();
+	m_Stats = {};
+}
+
+VulkanAllocation VulkanAllocator::AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+{
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(m_Device, buffer, &memRequirements);
+
+	VulkanAllocation allocation = Allocate(memRequirements, properties, true);
+	VK_CHECK_RESULT(vkBindBufferMemory(m_Device, buffer, allocation.Memory, allocation.Offset));
+	return allocation;
+}
+
+VulkanAllocation VulkanAllocator::AllocateImage(VkImage image, VkMemoryPropertyFlags properties, VkImageTiling tiling)
+{
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(m_Device, image, &memRequirements);
+
+	VulkanAllocation allocation = Allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_LINEAR);
+	VK_CHECK_RESULT(vkBindImageMemory(m_Device, image, allocation.Memory, allocation.Offset));
+	return allocation;
+}
+
+VulkanAllocation VulkanAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear)
+{
+	uint32_t memoryTypeIndex = m_PhysicalDevice->GetMemoryTypeIndex(requirements.memoryTypeBits, properties);
+	VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+
+	VulkanAllocation allocation;
+	allocation.MemoryTypeIndex = memoryTypeIndex;
+	allocation.Linear = linear;
+	allocation.Size = requirements.size;
+
+	std::scoped_lock lock(m_Mutex);
+
+	// 大资源单独分配，避免占满一个块
+	if (requirements.size > blockSize / 2)
+	{
+		// 专用分配不进入池，释放时直接归还给驱动
+		AllocateDeviceMemory(memoryTypeIndex, requirements.size, allocation.Memory, allocation.MappedData);
+		allocation.Dedicated = true;
+
+		m_Stats.BlockCount++;
+		m_Stats.ReservedBytes += requirements.size;
+		m_Stats.AllocationCount++;
+		m_Stats.UsedBytes += requirements.size;
+		return allocation;
+	}
+
+	MemoryPool& pool = m_Pools[GetPoolIndex(memoryTypeIndex, linear)];
+
+	VkDeviceSize offset = 0;
+	MemoryBlock* target = nullptr;
+	for (auto& block : pool.Blocks)
+	{
+		if (TryAllocateFromBlock(*block, requirements.size, requirements.alignment, offset))
+		{
+			target = block.get();
+			break;
+		}
+	}
+
+	if (!target)
+	{
+		pool.Blocks.push_back(CreateBlock(memoryTypeIndex, blockSize));
+		target = pool.Blocks.back().get();
+		m_BlockLookup[target->Memory] = target;
+
+		m_Stats.BlockCount++;
+		m_Stats.ReservedBytes += blockSize;
+
+		bool result = TryAllocateFromBlock(*target, requirements.size, requirements.alignment, offset);
+		CORE_ASSERT(result, "VulkanAllocator: allocation does not fit in a fresh block");
+	}
+
+	target->AllocationCount++;
+	m_Stats.AllocationCount++;
+	m_Stats.UsedBytes += requirements.size;
+
+	allocation.Memory = target->Memory;
+	allocation.Offset = offset;
+	if (target->MappedData)
+		allocation.MappedData = (uint8_t*)target->MappedData + offset;
+
+	return allocation;
+}
+
+void VulkanAllocator::Free(VulkanAllocation& allocation)
+{
+	if (!allocation.IsValid())
+		return;
+
+	std::scoped_lock lock(m_Mutex);
+
+	m_Stats.AllocationCount--;
+	m_Stats.UsedBytes -= allocation.Size;
+
+	if (allocation.Dedicated)
+	{
+		if (allocation.MappedData)
+			vkUnmapMemory(m_Device, allocation.Memory);
+		vkFreeMemory(m_Device, allocation.Memory, nullptr);
+
+		m_Stats.BlockCount--;
+		m_Stats.ReservedBytes -= allocation.Size;
+		allocation = {};
+		return;
+	}
+
+	auto it = m_BlockLookup.find(allocation.Memory);
+	CORE_ASSERT(it != m_BlockLookup.end(), "VulkanAllocator: freeing memory that was not allocated here");
+
+	MemoryBlock& block = *it->second;
+	ReleaseRange(block, allocation.Offset, allocation.Size);
+	block.AllocationCount--;
+
+	// 每个池至少保留一个块，多余的空块归还给驱动
+	if (block.AllocationCount == 0)
+	{
+		MemoryPool& pool = m_Pools[GetPoolIndex(allocation.MemoryTypeIndex, allocation.Linear)];
+		if (pool.Blocks.size() > 1)
+		{
+			m_Stats.BlockCount--;
+			m_Stats.ReservedBytes -= block.Size;
+			m_BlockLookup.erase(it);
+
+			DestroyBlock(block);
+			std::erase_if(pool.Blocks, [&block](const Scope<MemoryBlock>& b) { return b.get() == &block; });
+		}
+	}
+
+	allocation = {};
+}
+
+void VulkanAllocator::DestroyBuffer(VkBuffer buffer, VulkanAllocation& allocation)
+{
+	vkDestroyBuffer(m_Device, buffer, nullptr);
+	Free(allocation);
+}
+
+void VulkanAllocator::DestroyImage(VkImage image, VulkanAllocation& allocation)
+{
+	vkDestroyImage(m_Device, image, nullptr);
+	Free(allocation);
+}
+
+VulkanAllocatorStats VulkanAllocator::GetStats() const
+{
+	std::scoped_lock lock(m_Mutex);
+	return m_Stats;
+}
+
+bool VulkanAllocator::TryAllocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset)
+{
+	// First-fit：空闲区间按偏移排序，找到第一个对齐后放得下的区间
+	for (auto it = block.FreeRanges.begin(); it != block.FreeRanges.end(); ++it)
+	{
+		VkDeviceSize rangeOffset = it->first;
+		VkDeviceSize rangeSize = it->second;
+
+		VkDeviceSize alignedOffset = Utils::AlignUp(rangeOffset, alignment);
+		VkDeviceSize padding = alignedOffset - rangeOffset;
+		if (padding + size > rangeSize)
+			continue;
+
+		block.FreeRanges.erase(it);
+
+		// 对齐产生的前部空隙和剩余的尾部空间重新放回空闲链表
+		if (padding > 0)
+			block.FreeRanges[rangeOffset] = padding;
+		VkDeviceSize tail = rangeSize - padding - size;
+		if (tail > 0)
+			block.FreeRanges[alignedOffset + size] = tail;
+
+		outOffset = alignedOffset;
+		return true;
+	}
+	return false;
+}
+
+void VulkanAllocator::ReleaseRange(MemoryBlock& block, VkDeviceSize offset, VkDeviceSize size)
+{
+	auto next = block.FreeRanges.lower_bound(offset);
+
+	// 与后一个空闲区间合并
+	if (next != block.FreeRanges.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = block.FreeRanges.erase(next);
+	}
+
+	// 与前一个空闲区间合并
+	if (next != block.FreeRanges.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset)
+		{
+			prev->second += size;
+			return;
+		}
+	}
+
+	block.FreeRanges[offset] = size;
+}
+
+Scope<VulkanAllocator::MemoryBlock> VulkanAllocator::CreateBlock(uint32_t memoryTypeIndex, VkDeviceSize size)
+{
+	Scope<MemoryBlock> block = CreateScope<MemoryBlock>();
+	block->Size = size;
+	block->FreeRanges[0] = size;
+
+	AllocateDeviceMemory(memoryTypeIndex, size, block->Memory, block->MappedData);
+	return block;
+}
+
+void VulkanAllocator::AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& outMemory, void*& outMappedData)
+{
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+	VK_CHECK_RESULT(vkAllocateMemory(m_Device, &allocInfo, nullptr, &outMemory));
+
+	// 主机可见的内存整体常驻映射，避免同一块内存被多次vkMapMemory
+	outMappedData = nullptr;
+	const auto& memoryType = m_PhysicalDevice->GetMemoryProperties().memoryTypes[memoryTypeIndex];
+	if (memoryType.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		VK_CHECK_RESULT(vkMapMemory(m_Device, outMemory, 0, VK_WHOLE_SIZE, 0, &outMappedData));
+}
+
+void VulkanAllocator::DestroyBlock(MemoryBlock& block)
+{
+	if (block.MappedData)
+		vkUnmapMemory(m_Device, block.Memory);
+	vkFreeMemory(m_Device, block.Memory, nullptr);
+
+	block.Memory = nullptr;
+	block.MappedData = nullptr;
+}
+
+uint32_t VulkanAllocator::GetPoolIndex(uint32_t memoryTypeIndex, bool linear) const
+{
+	// 粒度为1时线性与非线性资源可以共用块
+	if (m_BufferImageGranularity <= 1)
+		linear = true;
+	return memoryTypeIndex * 2 + (linear ? 0 : 1);
+}
+
+VkDeviceSize VulkanAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+{
+	const auto& memoryProperties = m_PhysicalDevice->GetMemoryProperties();
+	VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+
+	// 小于1GB的堆使用堆大小的1/8作为块大小
+	if (heapSize <= 1024ull * 1024 * 1024)
+		return Utils::AlignUp(heapSize / 8, 32);
+	return DEFAULT_BLOCK_SIZE;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "Vulkan.h"
+
+#include <map>
+#include <mutex>
+
+class VulkanPhysicalDevice;
+
+// 一次子分配的结果，资源需要持有它直到销毁
+struct VulkanAllocation
+{
+	VkDeviceMemory Memory = nullptr;
+	VkDeviceSize Offset = 0;
+	VkDeviceSize Size = 0;
+	void* MappedData = nullptr;		// 仅HOST_VISIBLE内存有效，已加上Offset
+
+	uint32_t MemoryTypeIndex = UINT32_MAX;
+	bool Linear = true;				// 缓冲区/线性图像为true，最优平铺图像为false
+	bool Dedicated = false;			// 超过块大小时单独分配
+
+	bool IsValid() const { return Memory != nullptr; }
+};
+
+struct VulkanAllocatorStats
+{
+	uint32_t BlockCount = 0;			// vkAllocateMemory 次数（当前存活）
+	uint32_t AllocationCount = 0;		// 子分配次数（当前存活）
+	VkDeviceSize ReservedBytes = 0;
+	VkDeviceSize UsedBytes = 0;
+};
+
+// 设备内存分配器
+// 每种内存类型预留大块内存，在块内通过空闲链表（按偏移排序）分配对齐的子区间，
+// 释放时与相邻空闲区间合并。线性与非线性资源放在不同的块中以满足bufferImageGranularity
+class VulkanAllocator
+{
+public:
+	VulkanAllocator(VkDevice device, const Ref<VulkanPhysicalDevice>& physicalDevice);
+	~VulkanAllocator();
+
+	void Destroy();
+
+	// 分配并绑定
+	VulkanAllocation AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+	VulkanAllocation AllocateImage(VkImage image, VkMemoryPropertyFlags properties, VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL);
+
+	VulkanAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+	void Free(VulkanAllocation& allocation);
+
+	// 便捷函数：销毁资源并释放其内存
+	void DestroyBuffer(VkBuffer buffer, VulkanAllocation& allocation);
+	void DestroyImage(VkImage image, VulkanAllocation& allocation);
+
+	VulkanAllocatorStats GetStats() const;
+private:
+	struct MemoryBlock
+	{
+		VkDeviceMemory Memory = nullptr;
+		VkDeviceSize Size = 0;
+		void* MappedData = nullptr;
+
+		// 空闲区间：偏移 -> 大小
+		std::map<VkDeviceSize, VkDeviceSize> FreeRanges;
+		uint32_t AllocationCount = 0;
+	};
+
+	// 每个(内存类型, 线性/非线性)组合一个块列表
+	struct MemoryPool
+	{
+		std::vector<Scope<MemoryBlock>> Blocks;
+	};
+
+	bool TryAllocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset);
+	void ReleaseRange(MemoryBlock& block, VkDeviceSize offset, VkDeviceSize size);
+	Scope<MemoryBlock> CreateBlock(uint32_t memoryTypeIndex, VkDeviceSize size);
+	void AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& outMemory, void*& outMappedData);
+	void DestroyBlock(MemoryBlock& block);
+
+	uint32_t GetPoolIndex(uint32_t memoryTypeIndex, bool linear) const;
+	VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+private:
+	VkDevice m_Device = nullptr;
+	Ref<VulkanPhysicalDevice> m_PhysicalDevice;
+
+	VkDeviceSize m_BufferImageGranularity = 1;
+
+	std::vector<MemoryPool> m_Pools;
+	std::unordered_map<VkDeviceMemory, MemoryBlock*> m_BlockLookup;
+
+	VulkanAllocatorStats m_Stats;
+	mutable std::mutex m_Mutex;
+};
@@ -0,0 +1,170 @@
+#include "pch.h"
+#include "VulkanBindlessDescriptors.h"
+
+#include "VulkanContext.h"
+
+VulkanBindlessDescriptors::VulkanBindlessDescriptors(VkDevice device, const Ref<VulkanPhysicalDevice>& physicalDevice, uint32_t maxTextures, uint32_t maxStorageBuffers)
+	: m_Device(device)
+{
+	// 数组大小受UPDATE_AFTER_BIND限制约束
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties{};
+	indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+	VkPhysicalDeviceProperties2KHR properties2{};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+	properties2.pNext = &indexingProperties;
+	auto getPhysicalDeviceProperties2 = (PFN_vkGetPhysicalDeviceProperties2KHR)vkGetInstanceProcAddr(VulkanContext::GetInstance(), "vkGetPhysicalDeviceProperties2KHR");
+	getPhysicalDeviceProperties2(physicalDevice->GetVulkanPhysicalDevice(), &properties2);
+
+	m_Textures.Capacity = std::min({ maxTextures,
+		indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+		indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+		indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+		indexingProperties.maxDescriptorSetUpdateAfterBindSamplers });
+	m_StorageBuffers.Capacity = std::min({ maxStorageBuffers,
+		indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+		indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers });
+
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+	bindings[0].binding = TextureBinding;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = m_Textures.Capacity;
+	bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+	bindings[1].binding = StorageBufferBinding;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = m_StorageBuffers.Capacity;
+	bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+	// 未注册的索引不会被访问，不需要写入有效的描述符
+	std::array<VkDescriptorBindingFlagsEXT, 2> bindingFlags{};
+	bindingFlags[0] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+	bindingFlags[1] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+	bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+	bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &bindingFlagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_Layout));
+
+	std::array<VkDescriptorPoolSize, 2> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = m_Textures.Capacity;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = m_StorageBuffers.Capacity;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	VK_CHECK_RESULT(vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool));
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = m_DescriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &m_Layout;
+	VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device, &allocInfo, &m_DescriptorSet));
+
+	CORE_INFO("Bindless descriptors: {0} textures, {1} storage buffers", m_Textures.Capacity, m_StorageBuffers.Capacity);
+}
+
+VulkanBindlessDescriptors::~VulkanBindlessDescriptors()
+{
+}
+
+void VulkanBindlessDescriptors::Destroy()
+{
+	if (!m_DescriptorPool)
+		return;
+
+	vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(m_Device, m_Layout, nullptr);
+	m_DescriptorPool = nullptr;
+	m_Layout = nullptr;
+	m_DescriptorSet = nullptr;
+}
+
+uint32_t VulkanBindlessDescriptors::RegisterTexture(VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout)
+{
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageView = imageView;
+	imageInfo.sampler = sampler;
+	imageInfo.imageLayout = imageLayout;
+
+	std::scoped_lock lock(m_Mutex);
+	uint32_t index = m_Textures.Allocate();
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = m_DescriptorSet;
+	write.dstBinding = TextureBinding;
+	write.dstArrayElement = index;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.descriptorCount = 1;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+	return index;
+}
+
+void VulkanBindlessDescriptors::UnregisterTexture(uint32_t index)
+{
+	std::scoped_lock lock(m_Mutex);
+	m_Textures.Free(index);
+}
+
+uint32_t VulkanBindlessDescriptors::RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = offset;
+	bufferInfo.range = range;
+
+	std::scoped_lock lock(m_Mutex);
+	uint32_t index = m_StorageBuffers.Allocate();
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = m_DescriptorSet;
+	write.dstBinding = StorageBufferBinding;
+	write.dstArrayElement = index;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.descriptorCount = 1;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+	return index;
+}
+
+void VulkanBindlessDescriptors::UnregisterStorageBuffer(uint32_t index)
+{
+	std::scoped_lock lock(m_Mutex);
+	m_StorageBuffers.Free(index);
+}
+
+uint32_t VulkanBindlessDescriptors::IndexAllocator::Allocate()
+{
+	if (!FreeList.empty())
+	{
+		uint32_t index = FreeList.back();
+		FreeList.pop_back();
+		return index;
+	}
+
+	CORE_ASSERT(Next < Capacity, "Bindless descriptor array is full, increase VulkanConfig::BindlessMaxTextures/BindlessMaxStorageBuffers");
+	return Next++;
+}
+
+void VulkanBindlessDescriptors::IndexAllocator::Free(uint32_t index)
+{
+	CORE_ASSERT(index < Next, "Invalid bindless descriptor index!");
+	FreeList.push_back(index);
+}
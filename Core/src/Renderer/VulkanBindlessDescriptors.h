@@ -0,0 +1,57 @@
+#pragma once
+#include "Vulkan.h"
+
+#include <mutex>
+
+class VulkanPhysicalDevice;
+
+// bindless描述符集（VK_EXT_descriptor_indexing）
+// 整个程序只有一个描述符集，包含一个大的纹理数组和一个存储缓冲区数组，资源注册一次后通过索引访问，
+// 索引经推送常量或实例数据传给着色器。着色器中约定使用set = DescriptorSetIndex：
+//   layout(set = 1, binding = 0) uniform sampler2D textures[];
+//   layout(set = 1, binding = 1) buffer ... buffers[];
+// 描述符以UPDATE_AFTER_BIND方式更新，集合绑定后仍可注册新资源。
+// 注销的资源可能仍被飞行中的帧使用，应在GPU用完后再注销（例如VulkanFrameContext::DeferRelease）
+class VulkanBindlessDescriptors
+{
+public:
+	static constexpr uint32_t DescriptorSetIndex = 1;
+	static constexpr uint32_t TextureBinding = 0;
+	static constexpr uint32_t StorageBufferBinding = 1;
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+public:
+	VulkanBindlessDescriptors(VkDevice device, const Ref<VulkanPhysicalDevice>& physicalDevice, uint32_t maxTextures, uint32_t maxStorageBuffers);
+	~VulkanBindlessDescriptors();
+
+	void Destroy();
+
+	// 线程安全，返回着色器中使用的索引
+	uint32_t RegisterTexture(VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	void UnregisterTexture(uint32_t index);
+	uint32_t RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+	void UnregisterStorageBuffer(uint32_t index);
+
+	VkDescriptorSetLayout GetLayout() const { return m_Layout; }
+	VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
+private:
+	// 空闲索引优先复用，否则取下一个未使用的索引
+	struct IndexAllocator
+	{
+		uint32_t Capacity = 0;
+		uint32_t Next = 0;
+		std::vector<uint32_t> FreeList;
+
+		uint32_t Allocate();
+		void Free(uint32_t index);
+	};
+private:
+	VkDevice m_Device = nullptr;
+
+	VkDescriptorSetLayout m_Layout = nullptr;
+	VkDescriptorPool m_DescriptorPool = nullptr;
+	VkDescriptorSet m_DescriptorSet = nullptr;
+
+	IndexAllocator m_Textures;
+	IndexAllocator m_StorageBuffers;
+	std::mutex m_Mutex;
+};
@@ -51,17 +51,10 @@ VkCommandBuffer VulkanCommandPool::AllocateCommandBuffer(bool begin, bool comput
 	return cmdBuffer;
 }
 
-void VulkanCommandPool::FlushCommandBuffer(VkCommandBuffer commandBuffer)
+void VulkanCommandPool::FlushCommandBuffer(VkCommandBuffer commandBuffer, bool compute)
 {
 	auto device = VulkanContext::Get()->GetDevice();
-
-	FlushCommandBuffer(commandBuffer, device->GetGraphicsQueue());
-}
-
-void VulkanCommandPool::FlushCommandBuffer(VkCommandBuffer commandBuffer, VkQueue queue)
-{
-	auto device = VulkanContext::Get()->GetDevice();
-	CORE_ASSERT(queue == device->GetGraphicsQueue());
+	VkQueue queue = compute ? device->GetComputeQueue() : device->GetGraphicsQueue();
 	auto vulkanDevice = device->GetVulkanDevice();
 
 	const uint64_t DEFAULT_FENCE_TIMEOUT = 100000000000;
@@ -75,18 +68,15 @@ void VulkanCommandPool::FlushCommandBuffer(VkCommandBuffer commandBuffer, VkQueu
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
 
-	// Create fence to ensure that the command buffer has finished executing
-	VkFenceCreateInfo fenceCreateInfo = {};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = 0;
-	VkFence fence;
-	VK_CHECK_RESULT(vkCreateFence(vulkanDevice, &fenceCreateInfo, nullptr, &fence));
+	// 从设备的回收池中借用fence，避免每次提交都创建销毁
+	auto& syncPool = device->GetSyncPool();
+	VkFence fence = syncPool.AcquireFence();
 
-	VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
+	VK_CHECK_RESULT(device->QueueSubmit(queue, 1, &submitInfo, fence));
 
 	// Wait for the fence to signal that command buffer has finished executing
 	VK_CHECK_RESULT(vkWaitForFences(vulkanDevice, 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
 
-	vkDestroyFence(vulkanDevice, fence, nullptr);
-	vkFreeCommandBuffers(vulkanDevice, m_GraphicsCommandPool, 1, &commandBuffer);
+	syncPool.ReleaseFence(fence);
+	vkFreeCommandBuffers(vulkanDevice, compute ? m_ComputeCommandPool : m_GraphicsCommandPool, 1, &commandBuffer);
 }
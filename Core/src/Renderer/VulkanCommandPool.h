@@ -8,8 +8,8 @@ public:
 	~VulkanCommandPool();
 
 	VkCommandBuffer AllocateCommandBuffer(bool begin, bool compute);
-	void FlushCommandBuffer(VkCommandBuffer commandBuffer);
-	void FlushCommandBuffer(VkCommandBuffer commandBuffer, VkQueue queue);
+	// compute与分配时一致，提交到对应的队列并等待完成
+	void FlushCommandBuffer(VkCommandBuffer commandBuffer, bool compute = false);
 
 	VkCommandPool GetGraphicsCommandPool() const { return m_GraphicsCommandPool; }
 	VkCommandPool GetComputeCommandPool() const { return m_ComputeCommandPool; }
@@ -47,13 +47,26 @@ void VulkanContext::Init()
 	const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 	std::vector<const char*> instanceExtensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
 
+	// 查询设备扩展特性（如时间线信号量）需要vkGetPhysicalDeviceFeatures2KHR，不再只在验证层开启时启用
+	uint32_t availableExtensionCount = 0;
+	vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionCount, nullptr);
+	std::vector<VkExtensionProperties> availableExtensions(availableExtensionCount);
+	vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionCount, availableExtensions.data());
+	for (const auto& extension : availableExtensions)
+	{
+		if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0)
+		{
+			instanceExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+			break;
+		}
+	}
+
 	VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
 	if (enableValidationLayers) 
 	{
 		CORE_ASSERT(CheckValidationLayerSupport(), "validation layers requested, but not available!");
 
 		instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-		instanceExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 		
 		VulkanDebug::PopulateDebugMessengerCreateInfo(debugCreateInfo);
 
@@ -87,6 +100,8 @@ void VulkanContext::Init()
 	enabledFeatures.independentBlend = true;
 	enabledFeatures.pipelineStatisticsQuery = true;
 	enabledFeatures.shaderStorageImageReadWithoutFormat = true;
+	// 烘焙的纹理缓存按是否支持选择BC格式
+	enabledFeatures.textureCompressionBC = m_PhysicalDevice->GetFeatures().textureCompressionBC;
 	m_Device = CreateRef<VulkanDevice>(m_PhysicalDevice, enabledFeatures);
 }
 
@@ -0,0 +1,250 @@
+#include "pch.h"
+#include "VulkanDescriptorSetCache.h"
+
+#include "DescriptorSetManager.h"
+
+namespace Utils {
+
+	static void HashCombine(uint64_t& hash, uint64_t value)
+	{
+		hash ^= std::hash<uint64_t>()(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	}
+
+	static bool IsImageDescriptor(VkDescriptorType type)
+	{
+		return type == VK_DESCRIPTOR_TYPE_SAMPLER
+			|| type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+			|| type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+			|| type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+			|| type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+	}
+
+}
+
+void DescriptorSetDescription::AddBuffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	DescriptorResource& resource = Resources.emplace_back();
+	resource.Binding = binding;
+	resource.Type = type;
+	resource.Buffer = buffer;
+	resource.Offset = offset;
+	resource.Range = range;
+}
+
+void DescriptorSetDescription::AddBuffer(uint32_t binding, VkDescriptorType type, const VkDescriptorBufferInfo& bufferInfo)
+{
+	AddBuffer(binding, type, bufferInfo.buffer, bufferInfo.offset, bufferInfo.range);
+}
+
+void DescriptorSetDescription::AddImage(uint32_t binding, VkDescriptorType type, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout, uint32_t arrayElement)
+{
+	DescriptorResource& resource = Resources.emplace_back();
+	resource.Binding = binding;
+	resource.ArrayElement = arrayElement;
+	resource.Type = type;
+	resource.ImageView = imageView;
+	resource.Sampler = sampler;
+	resource.ImageLayout = imageLayout;
+}
+
+uint64_t DescriptorSetDescription::GetHash() const
+{
+	uint64_t hash = std::hash<uint64_t>()((uint64_t)Layout);
+	for (const auto& resource : Resources)
+	{
+		Utils::HashCombine(hash, (uint64_t)resource.Binding | ((uint64_t)resource.ArrayElement << 16) | ((uint64_t)resource.Type << 32));
+		if (Utils::IsImageDescriptor(resource.Type))
+		{
+			Utils::HashCombine(hash, (uint64_t)resource.ImageView);
+			Utils::HashCombine(hash, (uint64_t)resource.Sampler);
+			Utils::HashCombine(hash, (uint64_t)resource.ImageLayout);
+		}
+		else
+		{
+			Utils::HashCombine(hash, (uint64_t)resource.Buffer);
+			Utils::HashCombine(hash, resource.Offset);
+			Utils::HashCombine(hash, resource.Range);
+		}
+	}
+	return hash;
+}
+
+bool DescriptorSetDescription::operator==(const DescriptorSetDescription& other) const
+{
+	if (Layout != other.Layout || Resources.size() != other.Resources.size())
+		return false;
+
+	for (size_t i = 0; i < Resources.size(); i++)
+	{
+		const auto& a = Resources[i];
+		const auto& b = other.Resources[i];
+		if (a.Binding != b.Binding || a.ArrayElement != b.ArrayElement || a.Type != b.Type
+			|| a.Buffer != b.Buffer || a.Offset != b.Offset || a.Range != b.Range
+			|| a.ImageView != b.ImageView || a.Sampler != b.Sampler || a.ImageLayout != b.ImageLayout)
+			return false;
+	}
+	return true;
+}
+
+VulkanDescriptorSetCache::VulkanDescriptorSetCache(VkDevice device, DescriptorSetManager& descriptorSetManager, uint32_t framesInFlight, uint32_t maxAge)
+	: m_Device(device), m_DescriptorSetManager(descriptorSetManager), m_FramesInFlight(framesInFlight), m_MaxAge(std::max(maxAge, framesInFlight))
+{
+}
+
+VulkanDescriptorSetCache::~VulkanDescriptorSetCache()
+{
+}
+
+void VulkanDescriptorSetCache::Destroy()
+{
+	std::scoped_lock lock(m_Mutex);
+
+	CORE_INFO("VulkanDescriptorSetCache: {0} cached sets", m_SetCount);
+
+	// 设备已空闲，所有集合都可以直接释放
+	for (auto& [hash, entries] : m_Entries)
+	{
+		for (auto& entry : entries)
+			m_DescriptorSetManager.FreePersistent(entry.DescriptorSet);
+	}
+	m_Entries.clear();
+	m_SetCount = 0;
+
+	FreeRetired(true);
+}
+
+VkDescriptorSet VulkanDescriptorSetCache::Get(const DescriptorSetDescription& description)
+{
+	uint64_t hash = description.GetHash();
+
+	std::scoped_lock lock(m_Mutex);
+
+	auto& entries = m_Entries[hash];
+	for (auto& entry : entries)
+	{
+		if (entry.Description == description)
+		{
+			entry.LastUsedFrame = m_FrameNumber;
+			return entry.DescriptorSet;
+		}
+	}
+
+	CacheEntry& entry = entries.emplace_back();
+	entry.Description = description;
+	entry.DescriptorSet = m_DescriptorSetManager.AllocatePersistent(description.Layout);
+	entry.LastUsedFrame = m_FrameNumber;
+	m_SetCount++;
+
+	// 先收集所有信息结构体，写入时指针保持有效
+	std::vector<VkDescriptorBufferInfo> bufferInfos;
+	std::vector<VkDescriptorImageInfo> imageInfos;
+	bufferInfos.reserve(description.Resources.size());
+	imageInfos.reserve(description.Resources.size());
+
+	std::vector<VkWriteDescriptorSet> writes;
+	writes.reserve(description.Resources.size());
+	for (const auto& resource : description.Resources)
+	{
+		VkWriteDescriptorSet& write = writes.emplace_back();
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = entry.DescriptorSet;
+		write.dstBinding = resource.Binding;
+		write.dstArrayElement = resource.ArrayElement;
+		write.descriptorType = resource.Type;
+		write.descriptorCount = 1;
+
+		if (Utils::IsImageDescriptor(resource.Type))
+			write.pImageInfo = &imageInfos.emplace_back(VkDescriptorImageInfo{ resource.Sampler, resource.ImageView, resource.ImageLayout });
+		else
+			write.pBufferInfo = &bufferInfos.emplace_back(VkDescriptorBufferInfo{ resource.Buffer, resource.Offset, resource.Range });
+	}
+	vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	return entry.DescriptorSet;
+}
+
+void VulkanDescriptorSetCache::NextFrame()
+{
+	std::scoped_lock lock(m_Mutex);
+	m_FrameNumber++;
+
+	FreeRetired(false);
+
+	// 每maxAge帧检查一次，未使用的集合在maxAge到2*maxAge帧之间被回收
+	if (m_FrameNumber - m_LastEvictionFrame >= m_MaxAge)
+	{
+		EvictUnused();
+		m_LastEvictionFrame = m_FrameNumber;
+	}
+}
+
+void VulkanDescriptorSetCache::Invalidate(VkBuffer buffer)
+{
+	Invalidate((uint64_t)buffer);
+}
+
+void VulkanDescriptorSetCache::Invalidate(VkImageView imageView)
+{
+	Invalidate((uint64_t)imageView);
+}
+
+uint32_t VulkanDescriptorSetCache::GetSetCount() const
+{
+	std::scoped_lock lock(m_Mutex);
+	return m_SetCount;
+}
+
+void VulkanDescriptorSetCache::Invalidate(uint64_t handle)
+{
+	std::scoped_lock lock(m_Mutex);
+
+	for (auto it = m_Entries.begin(); it != m_Entries.end();)
+	{
+		std::erase_if(it->second, [this, handle](const CacheEntry& entry)
+		{
+			bool referenced = std::any_of(entry.Description.Resources.begin(), entry.Description.Resources.end(),
+				[handle](const DescriptorResource& resource) { return (uint64_t)resource.Buffer == handle || (uint64_t)resource.ImageView == handle; });
+			if (referenced)
+			{
+				m_RetiredSets.push_back({ entry.DescriptorSet, m_FrameNumber });
+				m_SetCount--;
+			}
+			return referenced;
+		});
+
+		it = it->second.empty() ? m_Entries.erase(it) : std::next(it);
+	}
+}
+
+void VulkanDescriptorSetCache::EvictUnused()
+{
+	// maxAge不小于飞行帧数，超过这个年龄的集合已不会被GPU使用，可以直接释放
+	uint32_t evicted = 0;
+	for (auto it = m_Entries.begin(); it != m_Entries.end();)
+	{
+		std::erase_if(it->second, [this, &evicted](const CacheEntry& entry)
+		{
+			if (m_FrameNumber - entry.LastUsedFrame < m_MaxAge)
+				return false;
+
+			m_DescriptorSetManager.FreePersistent(entry.DescriptorSet);
+			evicted++;
+			return true;
+		});
+
+		it = it->second.empty() ? m_Entries.erase(it) : std::next(it);
+	}
+	m_SetCount -= evicted;
+}
+
+void VulkanDescriptorSetCache::FreeRetired(bool all)
+{
+	std::erase_if(m_RetiredSets, [this, all](const RetiredSet& retired)
+	{
+		if (!all && m_FrameNumber - retired.RetiredFrame < m_FramesInFlight)
+			return false;
+
+		m_DescriptorSetManager.FreePersistent(retired.DescriptorSet);
+		return true;
+	});
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "Vulkan.h"
+
+#include <mutex>
+
+class DescriptorSetManager;
+
+// 描述符集中一个绑定的内容，缓冲区与图像字段按类型使用其一
+struct DescriptorResource
+{
+	uint32_t Binding = 0;
+	uint32_t ArrayElement = 0;
+	VkDescriptorType Type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+	VkBuffer Buffer = nullptr;
+	VkDeviceSize Offset = 0;
+	VkDeviceSize Range = 0;
+
+	VkImageView ImageView = nullptr;
+	VkSampler Sampler = nullptr;
+	VkImageLayout ImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+// 布局与所有绑定的资源，决定了一个描述符集的全部内容
+struct DescriptorSetDescription
+{
+	VkDescriptorSetLayout Layout = nullptr;
+	std::vector<DescriptorResource> Resources;
+
+	void AddBuffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+	void AddBuffer(uint32_t binding, VkDescriptorType type, const VkDescriptorBufferInfo& bufferInfo);
+	void AddImage(uint32_t binding, VkDescriptorType type, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, uint32_t arrayElement = 0);
+
+	uint64_t GetHash() const;
+	bool operator==(const DescriptorSetDescription& other) const;
+};
+
+// 按内容缓存的描述符集
+// 内容相同的描述符集只写入一次，之后只需一次哈希查找。集合来自DescriptorSetManager的持久池链，
+// 连续maxAge帧未被使用的集合被回收。资源销毁前需调用Invalidate()，否则句柄被复用时会命中失效的集合
+class VulkanDescriptorSetCache
+{
+public:
+	VulkanDescriptorSetCache(VkDevice device, DescriptorSetManager& descriptorSetManager, uint32_t framesInFlight, uint32_t maxAge);
+	~VulkanDescriptorSetCache();
+
+	void Destroy();
+
+	// 线程安全；未命中时分配并写入新的集合
+	VkDescriptorSet Get(const DescriptorSetDescription& description);
+
+	// 每帧开始时（该帧的fence等待完成后）调用一次，回收过期的集合
+	void NextFrame();
+	// 线程安全，移除引用该缓冲区或图像视图的集合，集合在飞行中的帧结束后释放
+	void Invalidate(VkBuffer buffer);
+	void Invalidate(VkImageView imageView);
+
+	uint32_t GetSetCount() const;
+private:
+	void Invalidate(uint64_t handle);
+	void EvictUnused();
+	void FreeRetired(bool all);
+private:
+	struct CacheEntry
+	{
+		DescriptorSetDescription Description;
+		VkDescriptorSet DescriptorSet = nullptr;
+		uint64_t LastUsedFrame = 0;
+	};
+
+	struct RetiredSet
+	{
+		VkDescriptorSet DescriptorSet = nullptr;
+		uint64_t RetiredFrame = 0;
+	};
+
+	VkDevice m_Device = nullptr;
+	DescriptorSetManager& m_DescriptorSetManager;
+	uint32_t m_FramesInFlight = 0;
+	uint32_t m_MaxAge = 0;
+
+	uint64_t m_FrameNumber = 0;
+	uint64_t m_LastEvictionFrame = 0;
+
+	// 哈希 -> 哈希相同的集合
+	std::unordered_map<uint64_t, std::vector<CacheEntry>> m_Entries;
+	uint32_t m_SetCount = 0;
+	// 已从缓存移除、仍可能被飞行中的帧使用的集合
+	std::vector<RetiredSet> m_RetiredSets;
+	mutable std::mutex m_Mutex;
+};
@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "VulkanDescriptorSetLayoutCache.h"
+
+VulkanDescriptorSetLayoutCache::VulkanDescriptorSetLayoutCache(VkDevice device)
+	: m_Device(device)
+{
+}
+
+VulkanDescriptorSetLayoutCache::~VulkanDescriptorSetLayoutCache()
+{
+}
+
+void VulkanDescriptorSetLayoutCache::Destroy()
+{
+	std::scoped_lock lock(m_Mutex);
+
+	CORE_INFO("VulkanDescriptorSetLayoutCache: {0} unique layouts", m_LayoutCount);
+
+	for (auto& [hash, entries] : m_Layouts)
+	{
+		for (auto& entry : entries)
+			vkDestroyDescriptorSetLayout(m_Device, entry.Layout, nullptr);
+	}
+	m_Layouts.clear();
+	m_LayoutCount = 0;
+}
+
+VkDescriptorSetLayout VulkanDescriptorSetLayoutCache::GetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags)
+{
+	// 不可变采样器不参与比较，使用它们的布局不应经过缓存
+	for (const auto& binding : bindings)
+		CORE_ASSERT(binding.pImmutableSamplers == nullptr, "Immutable samplers are not supported by the layout cache!");
+
+	std::sort(bindings.begin(), bindings.end(),
+		[](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+
+	uint64_t hash = Hash(bindings, flags);
+
+	std::scoped_lock lock(m_Mutex);
+
+	auto& entries = m_Layouts[hash];
+	for (const auto& entry : entries)
+	{
+		if (Equals(entry, bindings, flags))
+			return entry.Layout;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.flags = flags;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	LayoutEntry entry;
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &entry.Layout));
+	entry.Bindings = std::move(bindings);
+	entry.Flags = flags;
+	entries.push_back(std::move(entry));
+	m_LayoutCount++;
+
+	return entries.back().Layout;
+}
+
+uint32_t VulkanDescriptorSetLayoutCache::GetLayoutCount() const
+{
+	std::scoped_lock lock(m_Mutex);
+	return m_LayoutCount;
+}
+
+std::vector<VkDescriptorPoolSize> VulkanDescriptorSetLayoutCache::GetDescriptorCounts(VkDescriptorSetLayout layout) const
+{
+	std::scoped_lock lock(m_Mutex);
+
+	for (const auto& [hash, entries] : m_Layouts)
+	{
+		for (const auto& entry : entries)
+		{
+			if (entry.Layout != layout)
+				continue;
+
+			std::vector<VkDescriptorPoolSize> counts;
+			for (const auto& binding : entry.Bindings)
+			{
+				auto it = std::find_if(counts.begin(), counts.end(), [&binding](const VkDescriptorPoolSize& size) { return size.type == binding.descriptorType; });
+				if (it != counts.end())
+					it->descriptorCount += binding.descriptorCount;
+				else
+					counts.push_back({ binding.descriptorType, binding.descriptorCount });
+			}
+			return counts;
+		}
+	}
+	return {};
+}
+
+uint64_t VulkanDescriptorSetLayoutCache::Hash(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags)
+{
+	uint64_t hash = std::hash<uint32_t>()(flags);
+	for (const auto& binding : bindings)
+	{
+		// 每个绑定打包成一个64位值后混合
+		uint64_t packed = (uint64_t)binding.binding
+			| ((uint64_t)binding.descriptorType << 16)
+			| ((uint64_t)binding.stageFlags << 32)
+			| ((uint64_t)binding.descriptorCount << 48);
+		hash ^= std::hash<uint64_t>()(packed) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
+bool VulkanDescriptorSetLayoutCache::Equals(const LayoutEntry& entry, const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags)
+{
+	if (entry.Flags != flags || entry.Bindings.size() != bindings.size())
+		return false;
+
+	for (size_t i = 0; i < bindings.size(); i++)
+	{
+		const auto& a = entry.Bindings[i];
+		const auto& b = bindings[i];
+		if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Vulkan.h"
+
+#include <mutex>
+
+// 描述符布局缓存
+// 绑定完全相同的布局只创建一次，由所有着色器共享。布局归缓存所有，随设备一起销毁
+class VulkanDescriptorSetLayoutCache
+{
+public:
+	VulkanDescriptorSetLayoutCache(VkDevice device);
+	~VulkanDescriptorSetLayoutCache();
+
+	void Destroy();
+
+	// 线程安全；bindings的顺序不影响结果
+	VkDescriptorSetLayout GetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags = 0);
+
+	uint32_t GetLayoutCount() const;
+	// 分配一个该布局的集合所需的各类描述符数量；布局不是由缓存创建时为空
+	std::vector<VkDescriptorPoolSize> GetDescriptorCounts(VkDescriptorSetLayout layout) const;
+private:
+	struct LayoutEntry
+	{
+		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+		VkDescriptorSetLayoutCreateFlags Flags = 0;
+		VkDescriptorSetLayout Layout = nullptr;
+	};
+
+	static uint64_t Hash(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags);
+	static bool Equals(const LayoutEntry& entry, const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags);
+private:
+	VkDevice m_Device = nullptr;
+
+	// 哈希 -> 哈希相同的布局
+	std::unordered_map<uint64_t, std::vector<LayoutEntry>> m_Layouts;
+	uint32_t m_LayoutCount = 0;
+	mutable std::mutex m_Mutex;
+};
@@ -2,6 +2,47 @@
 #include "VulkanDevice.h"
 #include "VulkanContext.h"
 
+#include <atomic>
+
+struct VulkanCommandPoolRegistry
+{
+	std::mutex Mutex;
+	std::unordered_map<std::thread::id, Ref<VulkanCommandPool>> Pools;
+};
+
+namespace {
+	// 每个线程缓存自己的命令池，线程退出时从所属设备的注册表中注销
+	struct ThreadCommandPoolCache
+	{
+		uint64_t DeviceID = 0;
+		VulkanCommandPool* Pool = nullptr;
+		std::weak_ptr<VulkanCommandPoolRegistry> Registry;
+
+		~ThreadCommandPoolCache()
+		{
+			// 设备已销毁时注册表也不存在，命令池已随设备一起释放
+			if (auto registry = Registry.lock())
+			{
+				Ref<VulkanCommandPool> commandPool;
+				{
+					std::scoped_lock lock(registry->Mutex);
+					auto it = registry->Pools.find(std::this_thread::get_id());
+					if (it != registry->Pools.end())
+					{
+						commandPool = it->second;
+						registry->Pools.erase(it);
+					}
+				}
+				// 在锁外销毁命令池
+			}
+		}
+	};
+
+	thread_local ThreadCommandPoolCache t_CommandPoolCache;
+
+	std::atomic<uint64_t> s_NextDeviceID = 1;
+}
+
 VulkanPhysicalDevice::VulkanPhysicalDevice()
 {
     auto instance = VulkanContext::GetInstance();
@@ -53,7 +94,7 @@ VulkanPhysicalDevice::VulkanPhysicalDevice()
     // 获取请求的队列族类型的队列族索引
     // 请注意，这些索引可能会根据不同的实现而重叠
     static const float defaultQueuePriority(0.0f);
-    int requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+    int requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
     m_QueueFamilyIndices = GetQueueFamilyIndices(requestedQueueTypes);
 
 	// 图形队列
@@ -82,6 +123,21 @@ VulkanPhysicalDevice::VulkanPhysicalDevice()
 		}
 	}
 
+	// 传输队列
+	if (requestedQueueTypes & VK_QUEUE_TRANSFER_BIT)
+	{
+		if ((m_QueueFamilyIndices.Transfer != m_QueueFamilyIndices.Graphics) && (m_QueueFamilyIndices.Transfer != m_QueueFamilyIndices.Compute))
+		{
+			// 独立的传输队列族需要额外的队列创建信息
+			VkDeviceQueueCreateInfo queueInfo{};
+			queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueInfo.queueFamilyIndex = m_QueueFamilyIndices.Transfer;
+			queueInfo.queueCount = 1;
+			queueInfo.pQueuePriorities = &defaultQueuePriority;
+			m_QueueCreateInfos.push_back(queueInfo);
+		}
+	}
+
 	m_DepthFormat = FindDepthFormat();
 	CORE_ASSERT(m_DepthFormat);
 }
@@ -211,8 +267,10 @@ VkFormat VulkanPhysicalDevice::FindDepthFormat() const
 }
 
 VulkanDevice::VulkanDevice(const Ref<VulkanPhysicalDevice>& physicalDevice, VkPhysicalDeviceFeatures enabledFeatures)
-	: m_PhysicalDevice(physicalDevice), m_EnabledFeatures(enabledFeatures)
+	: m_PhysicalDevice(physicalDevice), m_EnabledFeatures(enabledFeatures), m_DeviceID(s_NextDeviceID++)
 {
+	m_CommandPoolRegistry = CreateRef<VulkanCommandPoolRegistry>();
+
 	std::vector<const char*> deviceExtensions;
 	// 如果设备将用于通过交换链（swapchain）向显示器呈现内容，我们需要请求交换链扩展。
 	CORE_ASSERT(m_PhysicalDevice->IsExtensionSupported(VK_KHR_SWAPCHAIN_EXTENSION_NAME));
@@ -224,8 +282,89 @@ VulkanDevice::VulkanDevice(const Ref<VulkanPhysicalDevice>& physicalDevice, VkPh
 	if (m_PhysicalDevice->IsExtensionSupported(VK_NV_DEVICE_DIAGNOSTICS_CONFIG_EXTENSION_NAME))
 		deviceExtensions.push_back(VK_NV_DEVICE_DIAGNOSTICS_CONFIG_EXTENSION_NAME);
 
+	// 时间线信号量，Vulkan 1.0下由扩展提供，需要通过vkGetPhysicalDeviceFeatures2KHR确认特性
+	bool timelineSemaphoreSupported = false;
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures{};
+	timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+	auto getPhysicalDeviceFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(VulkanContext::GetInstance(), "vkGetPhysicalDeviceFeatures2KHR");
+	if (getPhysicalDeviceFeatures2 && m_PhysicalDevice->IsExtensionSupported(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceFeatures2KHR features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+		features2.pNext = &timelineSemaphoreFeatures;
+		getPhysicalDeviceFeatures2(m_PhysicalDevice->GetVulkanPhysicalDevice(), &features2);
+
+		timelineSemaphoreSupported = timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE;
+		if (timelineSemaphoreSupported)
+			deviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+	}
+
+	// 用于统计管线创建是否命中缓存
+	bool creationFeedbackSupported = m_PhysicalDevice->IsExtensionSupported(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+	if (creationFeedbackSupported)
+		deviceExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+
+	// 视图可以通过VkImageViewUsageCreateInfoKHR收窄图像的用途，sRGB纹理的计算mip生成依赖它
+	m_Maintenance2 = m_PhysicalDevice->IsExtensionSupported(VK_KHR_MAINTENANCE2_EXTENSION_NAME);
+	if (m_Maintenance2)
+		deviceExtensions.push_back(VK_KHR_MAINTENANCE2_EXTENSION_NAME);
+
+	// 描述符索引（bindless），Vulkan 1.0下由扩展提供，依赖VK_KHR_maintenance3
+	const auto& config = VulkanContext::Get()->GetConfig();
+	bool descriptorIndexingSupported = false;
+	if (config.Bindless && getPhysicalDeviceFeatures2
+		&& m_PhysicalDevice->IsExtensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)
+		&& m_PhysicalDevice->IsExtensionSupported(VK_KHR_MAINTENANCE3_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT supportedIndexingFeatures{};
+		supportedIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		VkPhysicalDeviceFeatures2KHR features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+		features2.pNext = &supportedIndexingFeatures;
+		getPhysicalDeviceFeatures2(m_PhysicalDevice->GetVulkanPhysicalDevice(), &features2);
+
+		descriptorIndexingSupported = supportedIndexingFeatures.runtimeDescriptorArray
+			&& supportedIndexingFeatures.descriptorBindingPartiallyBound
+			&& supportedIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+			&& supportedIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind
+			&& m_PhysicalDevice->GetFeatures().shaderSampledImageArrayDynamicIndexing
+			&& m_PhysicalDevice->GetFeatures().shaderStorageBufferArrayDynamicIndexing;
+	}
+	if (config.Bindless && !descriptorIndexingSupported)
+		CORE_WARN("Descriptor indexing is not supported, bindless mode disabled");
+
+	// 只启用bindless需要的特性
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures{};
+	descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	if (descriptorIndexingSupported)
+	{
+		deviceExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+		deviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		enabledFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+		enabledFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+		m_EnabledFeatures = enabledFeatures;
+	}
+
+	// 扩展特性结构体串成pNext链
+	void* featureChain = nullptr;
+	if (timelineSemaphoreSupported)
+	{
+		timelineSemaphoreFeatures.pNext = featureChain;
+		featureChain = &timelineSemaphoreFeatures;
+	}
+	if (descriptorIndexingSupported)
+	{
+		descriptorIndexingFeatures.pNext = featureChain;
+		featureChain = &descriptorIndexingFeatures;
+	}
+
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	createInfo.pNext = featureChain;
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(physicalDevice->m_QueueCreateInfos.size());;
 	createInfo.pQueueCreateInfos = physicalDevice->m_QueueCreateInfos.data();
 	createInfo.pEnabledFeatures = &enabledFeatures;
@@ -236,6 +375,41 @@ VulkanDevice::VulkanDevice(const Ref<VulkanPhysicalDevice>& physicalDevice, VkPh
 
 	vkGetDeviceQueue(m_LogicalDevice, m_PhysicalDevice->m_QueueFamilyIndices.Graphics, 0, &m_GraphicsQueue);
 	vkGetDeviceQueue(m_LogicalDevice, m_PhysicalDevice->m_QueueFamilyIndices.Compute, 0, &m_ComputeQueue);
+
+	// 只有传输队列族与图形队列族不同时才值得走单独的传输路径
+	const auto& queueFamilyIndices = m_PhysicalDevice->m_QueueFamilyIndices;
+	if (VulkanContext::Get()->GetConfig().UseTransferQueue && queueFamilyIndices.Transfer != -1 && queueFamilyIndices.Transfer != queueFamilyIndices.Graphics)
+	{
+		vkGetDeviceQueue(m_LogicalDevice, queueFamilyIndices.Transfer, 0, &m_TransferQueue);
+		CORE_INFO("Using dedicated transfer queue family {0}", queueFamilyIndices.Transfer);
+	}
+
+	// 设备内存分配器
+	m_Allocator = CreateScope<VulkanAllocator>(m_LogicalDevice, m_PhysicalDevice);
+
+	// fence与信号量回收池
+	m_SyncPool = CreateScope<VulkanSyncPool>(m_LogicalDevice, timelineSemaphoreSupported);
+
+	// 所有上传共用的暂存环
+	m_StagingRing = CreateScope<VulkanStagingRing>(m_LogicalDevice, *m_Allocator, VulkanContext::Get()->GetConfig().StagingRingSize);
+
+	// 磁盘管线缓存
+	m_PipelineCache = CreateScope<VulkanPipelineCache>(m_LogicalDevice, m_PhysicalDevice, VulkanContext::Get()->GetConfig().PipelineCachePath, creationFeedbackSupported);
+
+	// 着色器共享的描述符布局
+	m_DescriptorSetLayoutCache = CreateScope<VulkanDescriptorSetLayoutCache>(m_LogicalDevice);
+
+	// 描述符池链，每个飞行帧一条临时链和一条持久链
+	m_DescriptorSetManager = CreateScope<DescriptorSetManager>(m_LogicalDevice, *m_DescriptorSetLayoutCache, config.FramesInFlight, config.DescriptorPoolSetCount);
+
+	// 按绑定内容缓存的描述符集，从持久链分配
+	m_DescriptorSetCache = CreateScope<VulkanDescriptorSetCache>(m_LogicalDevice, *m_DescriptorSetManager, config.FramesInFlight, config.DescriptorSetCacheMaxAge);
+
+	if (descriptorIndexingSupported)
+		m_BindlessDescriptors = CreateScope<VulkanBindlessDescriptors>(m_LogicalDevice, m_PhysicalDevice, config.BindlessMaxTextures, config.BindlessMaxStorageBuffers);
+
+	// 计算管线在第一次生成mip时创建
+	m_MipGenerator = CreateScope<VulkanMipGenerator>(m_LogicalDevice);
 }
 
 VulkanDevice::~VulkanDevice()
@@ -244,37 +418,84 @@ VulkanDevice::~VulkanDevice()
 
 void VulkanDevice::Destroy()
 {
-	m_CommandPools.clear();
+	{
+		std::scoped_lock lock(m_CommandPoolRegistry->Mutex);
+		m_CommandPoolRegistry->Pools.clear();
+	}
+	m_CommandPoolRegistry.reset();
 	vkDeviceWaitIdle(m_LogicalDevice);
+
+	m_MipGenerator->Destroy();
+	m_MipGenerator.reset();
+
+	m_PipelineCache->Destroy();
+	m_PipelineCache.reset();
+
+	m_DescriptorSetCache->Destroy();
+	m_DescriptorSetCache.reset();
+
+	m_DescriptorSetManager->Destroy();
+	m_DescriptorSetManager.reset();
+
+	m_DescriptorSetLayoutCache->Destroy();
+	m_DescriptorSetLayoutCache.reset();
+
+	if (m_BindlessDescriptors)
+	{
+		m_BindlessDescriptors->Destroy();
+		m_BindlessDescriptors.reset();
+	}
+
+	m_StagingRing->Destroy();
+	m_StagingRing.reset();
+
+	m_SyncPool->Destroy();
+	m_SyncPool.reset();
+
+	m_Allocator->Destroy();
+	m_Allocator.reset();
+
 	vkDestroyDevice(m_LogicalDevice, nullptr);
 }
 
 VkCommandBuffer VulkanDevice::GetCommandBuffer(bool begin, bool compute)
 {
-	return GetOrCreateThreadLocalCommandPool()->AllocateCommandBuffer(begin, compute);
+	return GetThreadLocalCommandPool().AllocateCommandBuffer(begin, compute);
 }
 
-void VulkanDevice::FlushCommandBuffer(VkCommandBuffer commandBuffer)
+void VulkanDevice::FlushCommandBuffer(VkCommandBuffer commandBuffer, bool compute)
 {
-	GetThreadLocalCommandPool()->FlushCommandBuffer(commandBuffer);
+	GetThreadLocalCommandPool().FlushCommandBuffer(commandBuffer, compute);
 }
 
-Ref<VulkanCommandPool> VulkanDevice::GetThreadLocalCommandPool()
+VkResult VulkanDevice::QueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* submits, VkFence fence)
 {
-	auto threadID = std::this_thread::get_id();
-	CORE_ASSERT(m_CommandPools.find(threadID) != m_CommandPools.end());
+	std::scoped_lock lock(m_QueueMutex);
+	return vkQueueSubmit(queue, submitCount, submits, fence);
+}
 
-	return m_CommandPools.at(threadID);
+VkResult VulkanDevice::QueuePresent(VkQueue queue, const VkPresentInfoKHR& presentInfo)
+{
+	std::scoped_lock lock(m_QueueMutex);
+	return vkQueuePresentKHR(queue, &presentInfo);
 }
 
-Ref<VulkanCommandPool> VulkanDevice::GetOrCreateThreadLocalCommandPool()
+VulkanCommandPool& VulkanDevice::GetThreadLocalCommandPool()
 {
-	auto threadID = std::this_thread::get_id();
-	auto commandPoolIt = m_CommandPools.find(threadID);
-	if (commandPoolIt != m_CommandPools.end())
-		return commandPoolIt->second;
+	// 快速路径：线程缓存命中时不加锁、不拷贝shared_ptr
+	ThreadCommandPoolCache& cache = t_CommandPoolCache;
+	if (cache.DeviceID == m_DeviceID && cache.Pool)
+		return *cache.Pool;
 
+	// 首次使用（或设备已重建）时创建并注册到设备
 	Ref<VulkanCommandPool> commandPool = CreateRef<VulkanCommandPool>();
-	m_CommandPools[threadID] = commandPool;
-	return commandPool;
+	{
+		std::scoped_lock lock(m_CommandPoolRegistry->Mutex);
+		m_CommandPoolRegistry->Pools[std::this_thread::get_id()] = commandPool;
+	}
+
+	cache.DeviceID = m_DeviceID;
+	cache.Pool = commandPool.get();
+	cache.Registry = m_CommandPoolRegistry;
+	return *cache.Pool;
 }
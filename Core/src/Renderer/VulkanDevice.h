@@ -2,7 +2,16 @@
 #include "Vulkan.h"
 
 #include "VulkanCommandPool.h"
-#include <map>
+#include "VulkanAllocator.h"
+#include "VulkanSyncPool.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanDescriptorSetLayoutCache.h"
+#include "VulkanBindlessDescriptors.h"
+#include "DescriptorSetManager.h"
+#include "VulkanDescriptorSetCache.h"
+#include "VulkanMipGenerator.h"
+#include "Buffer/VulkanStagingRing.h"
+#include <mutex>
 
 struct QueueFamilyIndices
 {
@@ -25,6 +34,8 @@ public:
 	VkFormat GetDepthFormat() const { return m_DepthFormat; }
 
 	VkPhysicalDevice GetVulkanPhysicalDevice() const { return m_PhysicalDevice; }
+	const VkPhysicalDeviceProperties& GetProperties() const { return m_Properties; }
+	const VkPhysicalDeviceFeatures& GetFeatures() const { return m_Features; }
 	const QueueFamilyIndices& GetQueueFamilyIndices() const { return m_QueueFamilyIndices; }
 	const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return m_MemoryProperties; }
 private:
@@ -53,6 +64,8 @@ private:
 	friend class VulkanDevice;
 };
 
+struct VulkanCommandPoolRegistry;
+
 class VulkanDevice
 {
 public:
@@ -63,23 +76,59 @@ public:
 
 	VkQueue GetGraphicsQueue() { return m_GraphicsQueue; }
 	VkQueue GetComputeQueue() { return m_ComputeQueue; }
+	// 未启用独立传输队列时为空，上传回落到图形队列
+	VkQueue GetTransferQueue() { return m_TransferQueue; }
+	bool HasTransferQueue() const { return m_TransferQueue != nullptr; }
+	// 是否启用了VK_KHR_maintenance2
+	bool HasMaintenance2() const { return m_Maintenance2; }
 
 	VkCommandBuffer GetCommandBuffer(bool begin, bool compute = false);
-	void FlushCommandBuffer(VkCommandBuffer commandBuffer);
+	void FlushCommandBuffer(VkCommandBuffer commandBuffer, bool compute = false);
+
+	// 队列需要外部同步，多个线程提交时统一经过这里
+	VkResult QueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* submits, VkFence fence);
+	VkResult QueuePresent(VkQueue queue, const VkPresentInfoKHR& presentInfo);
 
 	const Ref<VulkanPhysicalDevice>& GetPhysicalDevice() const { return m_PhysicalDevice; }
 	VkDevice GetVulkanDevice() const { return m_LogicalDevice; }
+
+	VulkanAllocator& GetAllocator() { return *m_Allocator; }
+	VulkanStagingRing& GetStagingRing() { return *m_StagingRing; }
+	VulkanSyncPool& GetSyncPool() { return *m_SyncPool; }
+	VulkanPipelineCache& GetPipelineCache() { return *m_PipelineCache; }
+	VulkanDescriptorSetLayoutCache& GetDescriptorSetLayoutCache() { return *m_DescriptorSetLayoutCache; }
+	DescriptorSetManager& GetDescriptorSetManager() { return *m_DescriptorSetManager; }
+	VulkanDescriptorSetCache& GetDescriptorSetCache() { return *m_DescriptorSetCache; }
+	// 未启用VulkanConfig::Bindless或设备不支持描述符索引时为空
+	VulkanBindlessDescriptors* GetBindlessDescriptors() { return m_BindlessDescriptors.get(); }
+	VulkanMipGenerator& GetMipGenerator() { return *m_MipGenerator; }
 private:
-	Ref<VulkanCommandPool> GetThreadLocalCommandPool();
-	Ref<VulkanCommandPool> GetOrCreateThreadLocalCommandPool();
+	// 当前线程的命令池，首次使用时创建并注册
+	VulkanCommandPool& GetThreadLocalCommandPool();
 private:
 	VkDevice m_LogicalDevice = nullptr;
 	Ref<VulkanPhysicalDevice> m_PhysicalDevice;
 	VkPhysicalDeviceFeatures m_EnabledFeatures;
+	bool m_Maintenance2 = false;
+
+	// 用于区分线程缓存属于哪个设备，设备重建后旧缓存失效
+	uint64_t m_DeviceID = 0;
+	Ref<VulkanCommandPoolRegistry> m_CommandPoolRegistry;
+
+	std::mutex m_QueueMutex;
 
-	std::map<std::thread::id, Ref<VulkanCommandPool>> m_CommandPools;
+	Scope<VulkanAllocator> m_Allocator;
+	Scope<VulkanSyncPool> m_SyncPool;
+	Scope<VulkanStagingRing> m_StagingRing;
+	Scope<VulkanPipelineCache> m_PipelineCache;
+	Scope<VulkanDescriptorSetLayoutCache> m_DescriptorSetLayoutCache;
+	Scope<DescriptorSetManager> m_DescriptorSetManager;
+	Scope<VulkanDescriptorSetCache> m_DescriptorSetCache;
+	Scope<VulkanBindlessDescriptors> m_BindlessDescriptors;
+	Scope<VulkanMipGenerator> m_MipGenerator;
 
 	VkQueue m_GraphicsQueue;
 	VkQueue m_ComputeQueue;
+	VkQueue m_TransferQueue = nullptr;
 };
 
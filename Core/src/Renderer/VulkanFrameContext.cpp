@@ -0,0 +1,143 @@
+#include "pch.h"
+#include "VulkanFrameContext.h"
+
+#include "VulkanContext.h"
+
+namespace Utils {
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+VulkanFrameContext::VulkanFrameContext(const Ref<VulkanDevice>& device, uint32_t queueFamilyIndex, uint32_t frameIndex)
+	: m_Device(device), m_QueueFamilyIndex(queueFamilyIndex), m_FrameIndex(frameIndex)
+{
+	auto vulkanDevice = m_Device->GetVulkanDevice();
+
+	// 整个池每帧重置一次，不单独重置命令缓冲区
+	VkCommandPoolCreateInfo cmdPoolInfo{};
+	cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	cmdPoolInfo.queueFamilyIndex = m_QueueFamilyIndex;
+	VK_CHECK_RESULT(vkCreateCommandPool(vulkanDevice, &cmdPoolInfo, nullptr, &m_CommandPool));
+
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = m_CommandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	VK_CHECK_RESULT(vkAllocateCommandBuffers(vulkanDevice, &allocInfo, &m_CommandBuffer));
+
+	CreateUniformBuffer();
+}
+
+VulkanFrameContext::~VulkanFrameContext()
+{
+	auto vulkanDevice = m_Device->GetVulkanDevice();
+
+	RunDeferredReleases();
+
+	vkDestroyCommandPool(vulkanDevice, m_CommandPool, nullptr);
+	for (auto& secondary : m_SecondaryCommandBuffers)
+		vkDestroyCommandPool(vulkanDevice, secondary.CommandPool, nullptr);
+	m_SecondaryCommandBuffers.clear();
+
+	m_Device->GetDescriptorSetCache().Invalidate(m_UniformBuffer);
+	m_Device->GetAllocator().DestroyBuffer(m_UniformBuffer, m_UniformAllocation);
+}
+
+void VulkanFrameContext::Reset()
+{
+	auto vulkanDevice = m_Device->GetVulkanDevice();
+
+	RunDeferredReleases();
+
+	VK_CHECK_RESULT(vkResetCommandPool(vulkanDevice, m_CommandPool, 0));
+	for (auto& secondary : m_SecondaryCommandBuffers)
+		VK_CHECK_RESULT(vkResetCommandPool(vulkanDevice, secondary.CommandPool, 0));
+
+	m_Device->GetDescriptorSetManager().ResetFrame(m_FrameIndex);
+	m_UniformOffset = 0;
+}
+
+void VulkanFrameContext::ReserveSecondaryCommandBuffers(uint32_t count)
+{
+	auto vulkanDevice = m_Device->GetVulkanDevice();
+
+	// 每个二级命令缓冲区使用独立的命令池，工作线程录制时无需加锁
+	VkCommandPoolCreateInfo cmdPoolInfo{};
+	cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	cmdPoolInfo.queueFamilyIndex = m_QueueFamilyIndex;
+
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	allocInfo.commandBufferCount = 1;
+
+	while (m_SecondaryCommandBuffers.size() < count)
+	{
+		FrameCommandBuffer& secondary = m_SecondaryCommandBuffers.emplace_back();
+		VK_CHECK_RESULT(vkCreateCommandPool(vulkanDevice, &cmdPoolInfo, nullptr, &secondary.CommandPool));
+
+		allocInfo.commandPool = secondary.CommandPool;
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(vulkanDevice, &allocInfo, &secondary.CommandBuffer));
+	}
+}
+
+VkDescriptorSet VulkanFrameContext::AllocateDescriptorSet(VkDescriptorSetLayout layout)
+{
+	return m_Device->GetDescriptorSetManager().AllocateTransient(m_FrameIndex, layout);
+}
+
+FrameUniformAllocation VulkanFrameContext::AllocateUniform(VkDeviceSize size)
+{
+	// 偏移始终保持对齐，只需对大小向上取整
+	VkDeviceSize alignedSize = Utils::AlignUp(size, m_UniformAlignment);
+	VkDeviceSize offset = m_UniformOffset.fetch_add(alignedSize);
+	CORE_ASSERT(offset + alignedSize <= m_UniformSize, "Frame uniform buffer is full, increase VulkanConfig::FrameUniformBufferSize");
+
+	FrameUniformAllocation allocation;
+	allocation.Buffer = m_UniformBuffer;
+	allocation.Offset = offset;
+	allocation.Size = size;
+	allocation.Data = (uint8_t*)m_UniformAllocation.MappedData + offset;
+	return allocation;
+}
+
+void VulkanFrameContext::DeferRelease(std::function<void()> func)
+{
+	std::scoped_lock lock(m_DeferredMutex);
+	m_DeferredReleases.push_back(std::move(func));
+}
+
+void VulkanFrameContext::RunDeferredReleases()
+{
+	std::vector<std::function<void()>> releases;
+	{
+		std::scoped_lock lock(m_DeferredMutex);
+		releases.swap(m_DeferredReleases);
+	}
+
+	for (auto& release : releases)
+		release();
+}
+
+void VulkanFrameContext::CreateUniformBuffer()
+{
+	m_UniformSize = VulkanContext::Get()->GetConfig().FrameUniformBufferSize;
+	// 动态偏移是32位的
+	CORE_ASSERT(m_UniformSize <= UINT32_MAX, "VulkanConfig::FrameUniformBufferSize must fit in a dynamic offset");
+	m_UniformAlignment = std::max<VkDeviceSize>(m_Device->GetPhysicalDevice()->GetProperties().limits.minUniformBufferOffsetAlignment, 16);
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = m_UniformSize;
+	bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	VK_CHECK_RESULT(vkCreateBuffer(m_Device->GetVulkanDevice(), &bufferInfo, nullptr, &m_UniformBuffer));
+
+	m_UniformAllocation = m_Device->GetAllocator().AllocateBuffer(m_UniformBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	CORE_ASSERT(m_UniformAllocation.MappedData, "Frame uniform buffer memory is not host visible!");
+}
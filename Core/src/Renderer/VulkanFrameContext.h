@@ -0,0 +1,75 @@
+#pragma once
+#include "Vulkan.h"
+
+#include "VulkanAllocator.h"
+
+#include <atomic>
+#include <mutex>
+
+class VulkanDevice;
+
+// 从帧上下文的uniform区间中分配的一段，Data可直接写入
+struct FrameUniformAllocation
+{
+	VkBuffer Buffer = nullptr;
+	// 相对于uniform缓冲区起点，绑定UNIFORM_BUFFER_DYNAMIC时直接作为动态偏移
+	VkDeviceSize Offset = 0;
+	VkDeviceSize Size = 0;
+	void* Data = nullptr;
+};
+
+// 一个飞行帧独占的临时资源：主命令缓冲区、并行录制用的二级命令缓冲区、
+// DescriptorSetManager中该帧的临时描述符池链以及uniform环中属于该帧的区间
+// 数量只取决于VulkanConfig::FramesInFlight，与交换链图像数量无关。
+// Reset()必须在该帧的fence等待完成之后调用，之前分配的所有资源在Reset()后失效
+class VulkanFrameContext
+{
+public:
+	VulkanFrameContext(const Ref<VulkanDevice>& device, uint32_t queueFamilyIndex, uint32_t frameIndex);
+	~VulkanFrameContext();
+
+	void Reset();
+
+	VkCommandBuffer GetCommandBuffer() const { return m_CommandBuffer; }
+
+	// 主线程上预先创建count个二级命令缓冲区，之后每个索引只能由一个线程使用
+	void ReserveSecondaryCommandBuffers(uint32_t count);
+	VkCommandBuffer GetSecondaryCommandBuffer(uint32_t index) const { return m_SecondaryCommandBuffers[index].CommandBuffer; }
+
+	// 线程安全，分配的描述符集只在本帧内有效
+	VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout layout);
+	// 线程安全，按minUniformBufferOffsetAlignment对齐
+	FrameUniformAllocation AllocateUniform(VkDeviceSize size);
+	// 本帧所有uniform分配所在的缓冲区，描述符集以它为基址、以分配的偏移作为动态偏移
+	VkBuffer GetUniformBuffer() const { return m_UniformBuffer; }
+
+	// 线程安全，func在该帧下次Reset()时（GPU已不再使用本帧的资源）执行，用于延迟销毁被替换的对象
+	void DeferRelease(std::function<void()> func);
+private:
+	void RunDeferredReleases();
+	void CreateUniformBuffer();
+private:
+	Ref<VulkanDevice> m_Device;
+	uint32_t m_QueueFamilyIndex = 0;
+	uint32_t m_FrameIndex = 0;
+
+	struct FrameCommandBuffer
+	{
+		VkCommandPool CommandPool = nullptr;
+		VkCommandBuffer CommandBuffer = nullptr;
+	};
+
+	VkCommandPool m_CommandPool = nullptr;
+	VkCommandBuffer m_CommandBuffer = nullptr;
+	std::vector<FrameCommandBuffer> m_SecondaryCommandBuffers;
+
+	// uniform环中属于本帧的区间，线性分配，Reset()时整体回收
+	VkBuffer m_UniformBuffer = nullptr;
+	VulkanAllocation m_UniformAllocation;
+	VkDeviceSize m_UniformSize = 0;
+	VkDeviceSize m_UniformAlignment = 256;
+	std::atomic<VkDeviceSize> m_UniformOffset = 0;
+
+	std::vector<std::function<void()>> m_DeferredReleases;
+	std::mutex m_DeferredMutex;
+};
@@ -0,0 +1,171 @@
+#include "pch.h"
+#include "VulkanMipGenerator.h"
+
+#include "VulkanContext.h"
+#include "VulkanShader.h"
+
+namespace Utils {
+
+	static const char* s_MipGenerationShaderPath = "Shaders/mipgen.comp";
+
+	// 与mipgen.comp中的PushConstants一致
+	struct MipGenerationPushConstants
+	{
+		int32_t SrcWidth;
+		int32_t SrcHeight;
+		uint32_t LevelCount;
+		uint32_t SRGB;
+	};
+
+	static bool IsSRGB(VkFormat format)
+	{
+		return format == VK_FORMAT_R8G8B8A8_SRGB;
+	}
+
+}
+
+VulkanMipGenerator::VulkanMipGenerator(VkDevice device)
+	: m_Device(device)
+{
+}
+
+VulkanMipGenerator::~VulkanMipGenerator()
+{
+}
+
+void VulkanMipGenerator::Destroy()
+{
+	if (m_Pipeline)
+		vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
+	if (m_PipelineLayout)
+		vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+	m_Pipeline = nullptr;
+	m_PipelineLayout = nullptr;
+}
+
+bool VulkanMipGenerator::IsFormatSupported(VkFormat format)
+{
+	if (format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB)
+		return false;
+	// sRGB采样视图不支持图像的STORAGE用途，需要VK_KHR_maintenance2收窄视图用途
+	if (Utils::IsSRGB(format) && !VulkanContext::Get()->GetDevice()->HasMaintenance2())
+		return false;
+
+	// 图像以存储格式创建，这里确认设备支持该格式与用途的组合，不支持时调用方退回blit
+	VkImageFormatProperties properties;
+	VkResult result = vkGetPhysicalDeviceImageFormatProperties(VulkanContext::Get()->GetPhysicalDevice()->GetVulkanPhysicalDevice(),
+		GetStorageFormat(format), VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_OPTIMAL, GetImageUsage(), VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT, &properties);
+	return result == VK_SUCCESS;
+}
+
+VkImageUsageFlags VulkanMipGenerator::GetImageUsage()
+{
+	return VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+}
+
+VkFormat VulkanMipGenerator::GetStorageFormat(VkFormat format)
+{
+	return Utils::IsSRGB(format) ? VK_FORMAT_R8G8B8A8_UNORM : format;
+}
+
+void VulkanMipGenerator::Generate(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, const std::vector<VkImageView>& storageViews)
+{
+	CORE_ASSERT(IsFormatSupported(format), "Unsupported format for compute mip generation!");
+	std::call_once(m_CreateOnce, [this]() { CreatePipeline(); });
+
+	auto& descriptorSetCache = VulkanContext::Get()->GetDevice()->GetDescriptorSetCache();
+	uint32_t mipLevels = static_cast<uint32_t>(storageViews.size());
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.image = image;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 1;
+
+	for (uint32_t srcLevel = 0; srcLevel + 1 < mipLevels; srcLevel += MaxLevelsPerDispatch)
+	{
+		// 上一次调度写入的最后一级是这次的源
+		if (srcLevel > 0)
+		{
+			barrier.subresourceRange.baseMipLevel = srcLevel;
+			vkCmdPipelineBarrier(commandBuffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+				0, nullptr,
+				0, nullptr,
+				1, &barrier);
+		}
+
+		uint32_t levelCount = std::min(MaxLevelsPerDispatch, mipLevels - 1 - srcLevel);
+
+		// 未使用的数组元素填入最后一级的视图，着色器不会写入它们
+		DescriptorSetDescription description;
+		description.Layout = m_DescriptorSetLayout;
+		description.AddImage(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, storageViews[srcLevel], nullptr, VK_IMAGE_LAYOUT_GENERAL);
+		for (uint32_t i = 0; i < MaxLevelsPerDispatch; i++)
+		{
+			uint32_t dstLevel = srcLevel + 1 + std::min(i, levelCount - 1);
+			description.AddImage(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, storageViews[dstLevel], nullptr, VK_IMAGE_LAYOUT_GENERAL, i);
+		}
+
+		VkDescriptorSet descriptorSet = descriptorSetCache.Get(description);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+		Utils::MipGenerationPushConstants pushConstants;
+		pushConstants.SrcWidth = static_cast<int32_t>(std::max(width >> srcLevel, 1u));
+		pushConstants.SrcHeight = static_cast<int32_t>(std::max(height >> srcLevel, 1u));
+		pushConstants.LevelCount = levelCount;
+		pushConstants.SRGB = Utils::IsSRGB(format) ? 1 : 0;
+		vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+
+		// 每个工作组覆盖64x64个源纹素
+		uint32_t groupCountX = (pushConstants.SrcWidth + 63) / 64;
+		uint32_t groupCountY = (pushConstants.SrcHeight + 63) / 64;
+		vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+	}
+}
+
+void VulkanMipGenerator::CreatePipeline()
+{
+	auto vkDevice = VulkanContext::Get()->GetDevice();
+
+	std::vector<uint32_t> spirv = VulkanShader::LoadSPIRV(Utils::s_MipGenerationShaderPath, 2);
+	ShaderReflection reflection = ShaderReflection::Reflect(spirv, VK_SHADER_STAGE_COMPUTE_BIT);
+
+	m_DescriptorSetLayout = vkDevice->GetDescriptorSetLayoutCache().GetLayout(reflection.GetSetBindings(0));
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(reflection.PushConstantRanges.size());
+	pipelineLayoutInfo.pPushConstantRanges = reflection.PushConstantRanges.data();
+	VK_CHECK_RESULT(vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_PipelineLayout));
+
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = spirv.size() * sizeof(uint32_t);
+	moduleInfo.pCode = spirv.data();
+	VkShaderModule shaderModule;
+	VK_CHECK_RESULT(vkCreateShaderModule(m_Device, &moduleInfo, nullptr, &shaderModule));
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = m_PipelineLayout;
+	VK_CHECK_RESULT(vkDevice->GetPipelineCache().CreateComputePipeline(pipelineInfo, m_Pipeline));
+
+	// 管线创建后模块不再需要
+	vkDestroyShaderModule(m_Device, shaderModule, nullptr);
+}
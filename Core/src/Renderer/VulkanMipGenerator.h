@@ -0,0 +1,43 @@
+#pragma once
+#include "Vulkan.h"
+
+#include <mutex>
+
+// 计算着色器生成mip链
+// 每次调度在共享内存中逐级下采样，最多生成MaxLevelsPerDispatch个级别，4096的纹理只需两次调度。
+// sRGB纹理以UNORM格式创建并通过UNORM存储视图读写，着色器在线性空间中滤波。可以记录在图形队列或计算队列的命令缓冲区中
+class VulkanMipGenerator
+{
+public:
+	static constexpr uint32_t MaxLevelsPerDispatch = 6;
+
+	VulkanMipGenerator(VkDevice device);
+	~VulkanMipGenerator();
+
+	void Destroy();
+
+	// 支持的图像格式，并且设备支持以存储格式与GetImageUsage()创建可变格式的图像
+	static bool IsFormatSupported(VkFormat format);
+	// 存储视图使用的格式，sRGB格式对应的UNORM格式。
+	// 图像本身以该格式和VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT创建，再通过只带SAMPLED用途的sRGB视图采样；
+	// 多数设备的sRGB格式不支持STORAGE，不能直接以sRGB格式创建带STORAGE用途的图像
+	static VkFormat GetStorageFormat(VkFormat format);
+	// 图像需要的用途
+	static VkImageUsageFlags GetImageUsage();
+
+	// storageViews为每个级别的单级别视图，格式为GetStorageFormat(format)
+	// 调用前所有级别处于GENERAL且level 0的内容对计算着色器可见；
+	// 返回时所有级别仍处于GENERAL，最后一次调度的写入由调用方的屏障同步给后续使用者
+	void Generate(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, const std::vector<VkImageView>& storageViews);
+private:
+	// 第一次使用时编译着色器并创建管线，线程安全
+	void CreatePipeline();
+private:
+	VkDevice m_Device = nullptr;
+
+	// 布局归VulkanDescriptorSetLayoutCache所有
+	VkDescriptorSetLayout m_DescriptorSetLayout = nullptr;
+	VkPipelineLayout m_PipelineLayout = nullptr;
+	VkPipeline m_Pipeline = nullptr;
+	std::once_flag m_CreateOnce;
+};
@@ -2,12 +2,108 @@
 #include "VulkanPipeline.h"
 
 #include "Renderer/VulkanContext.h"
+#include "Application.h"
 #include "Data/Vertex.h"
 
-VulkanPipeline::VulkanPipeline(Ref<VulkanShader> shader)
-	: m_Shader(shader)
+#include <mutex>
+
+namespace Utils {
+
+	static void HashCombine(uint64_t& hash, uint64_t value)
+	{
+		hash ^= std::hash<uint64_t>()(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	}
+
+	// 哈希 -> 哈希相同的管线；只保存弱引用，不再使用的管线随最后一个引用释放
+	struct PipelineStateCache
+	{
+		std::unordered_map<uint64_t, std::vector<std::weak_ptr<VulkanPipeline>>> Pipelines;
+		std::mutex Mutex;
+
+		Ref<VulkanPipeline> Find(uint64_t hash, const PipelineSpecification& specification)
+		{
+			auto it = Pipelines.find(hash);
+			if (it == Pipelines.end())
+				return nullptr;
+
+			auto& entries = it->second;
+			std::erase_if(entries, [](const std::weak_ptr<VulkanPipeline>& entry) { return entry.expired(); });
+
+			for (const auto& entry : entries)
+			{
+				Ref<VulkanPipeline> pipeline = entry.lock();
+				if (pipeline && pipeline->GetSpecification() == specification)
+					return pipeline;
+			}
+
+			if (entries.empty())
+				Pipelines.erase(it);
+			return nullptr;
+		}
+	};
+
+	static PipelineStateCache s_PipelineStateCache;
+
+}
+
+uint64_t PipelineSpecification::GetHash() const
+{
+	uint64_t hash = std::hash<const void*>()(Shader.get());
+
+	Utils::HashCombine(hash, Layout.Stride);
+	for (const auto& attribute : Layout.Attributes)
+		Utils::HashCombine(hash, (uint64_t)attribute.Location | ((uint64_t)attribute.Format << 16) | ((uint64_t)attribute.Offset << 40));
+
+	Utils::HashCombine(hash, (uint64_t)Topology | ((uint64_t)PolygonMode << 8) | ((uint64_t)CullMode << 16) | ((uint64_t)FrontFace << 24)
+		| ((uint64_t)DepthTest << 32) | ((uint64_t)DepthWrite << 33) | ((uint64_t)DepthCompareOp << 34)
+		| ((uint64_t)BlendEnable << 40) | ((uint64_t)Samples << 48));
+
+	if (BlendEnable)
+	{
+		Utils::HashCombine(hash, (uint64_t)SrcColorBlendFactor | ((uint64_t)DstColorBlendFactor << 8) | ((uint64_t)ColorBlendOp << 16)
+			| ((uint64_t)SrcAlphaBlendFactor << 24) | ((uint64_t)DstAlphaBlendFactor << 32) | ((uint64_t)AlphaBlendOp << 40));
+	}
+
+	Utils::HashCombine(hash, (uint64_t)RenderPass);
+	Utils::HashCombine(hash, Subpass);
+	return hash;
+}
+
+bool PipelineSpecification::operator==(const PipelineSpecification& other) const
+{
+	if (Shader != other.Shader || Layout.Stride != other.Layout.Stride || Layout.Attributes.size() != other.Layout.Attributes.size())
+		return false;
+
+	for (size_t i = 0; i < Layout.Attributes.size(); i++)
+	{
+		const auto& a = Layout.Attributes[i];
+		const auto& b = other.Layout.Attributes[i];
+		if (a.Location != b.Location || a.Format != b.Format || a.Offset != b.Offset)
+			return false;
+	}
+
+	if (Topology != other.Topology || PolygonMode != other.PolygonMode || CullMode != other.CullMode || FrontFace != other.FrontFace
+		|| DepthTest != other.DepthTest || DepthWrite != other.DepthWrite || DepthCompareOp != other.DepthCompareOp
+		|| BlendEnable != other.BlendEnable || Samples != other.Samples
+		|| RenderPass != other.RenderPass || Subpass != other.Subpass)
+		return false;
+
+	if (BlendEnable)
+	{
+		return SrcColorBlendFactor == other.SrcColorBlendFactor && DstColorBlendFactor == other.DstColorBlendFactor && ColorBlendOp == other.ColorBlendOp
+			&& SrcAlphaBlendFactor == other.SrcAlphaBlendFactor && DstAlphaBlendFactor == other.DstAlphaBlendFactor && AlphaBlendOp == other.AlphaBlendOp;
+	}
+	return true;
+}
+
+VulkanPipeline::VulkanPipeline(const PipelineSpecification& specification)
+	: m_Specification(specification)
 {
-	Invalidate();
+	// 交换链的渲染过程在整个生命周期内不变，解析后再参与比较
+	if (!m_Specification.RenderPass)
+		m_Specification.RenderPass = VulkanContext::Get()->GetSwapChain().GetRenderPass();
+
+	m_BuildFuture = m_BuildPromise.get_future().share();
 }
 
 VulkanPipeline::~VulkanPipeline()
@@ -23,7 +119,12 @@ VulkanPipeline::~VulkanPipeline()
 void VulkanPipeline::Invalidate()
 {
 	auto device = VulkanContext::Get()->GetCurrentDevice();
-	auto descriptorSetLayouts = m_Shader->GetDescriptorSetLayout();
+
+	const auto& spec = m_Specification;
+
+	// 描述符布局与推送常量来自着色器反射
+	const auto& reflection = spec.Shader->GetReflection();
+	const auto& descriptorSetLayouts = spec.Shader->GetDescriptorSetLayouts();
 
 	// 启用动态状态
 	// 大多数状态都已烘焙到管线中，但仍然有一些动态状态可以在命令缓冲区中更改
@@ -42,9 +143,9 @@ void VulkanPipeline::Invalidate()
 	// 我们只使用深度测试，并希望启用深度测试和深度写入，比较方式为小于或等于
 	VkPipelineDepthStencilStateCreateInfo depthStencil{};
 	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-	depthStencil.depthTestEnable = VK_TRUE;
-	depthStencil.depthWriteEnable = VK_TRUE;
-	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencil.depthTestEnable = spec.DepthTest ? VK_TRUE : VK_FALSE;
+	depthStencil.depthWriteEnable = spec.DepthWrite ? VK_TRUE : VK_FALSE;
+	depthStencil.depthCompareOp = spec.DepthCompareOp;
 	depthStencil.depthBoundsTestEnable = VK_FALSE;
 	depthStencil.stencilTestEnable = VK_FALSE;
 
@@ -52,10 +153,39 @@ void VulkanPipeline::Invalidate()
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-	auto bindingDescription = Vertex::GetBindingDescription();
-	auto attributeDescriptions = Vertex::GetAttributeDescriptions();
+	VkVertexInputBindingDescription bindingDescription{};
+	bindingDescription.binding = 0;
+	bindingDescription.stride = 0;
+	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+	if (spec.Layout.Attributes.empty())
+	{
+		// 未指定顶点布局时，所有输入按location顺序紧密排列在绑定0中
+		for (const auto& input : reflection.VertexInputs)
+		{
+			VkVertexInputAttributeDescription& attribute = attributeDescriptions.emplace_back();
+			attribute.binding = 0;
+			attribute.location = input.Location;
+			attribute.format = input.Format;
+			attribute.offset = bindingDescription.stride;
+			bindingDescription.stride += input.Size;
+		}
+	}
+	else
+	{
+		bindingDescription.stride = spec.Layout.Stride;
+		for (const auto& layoutAttribute : spec.Layout.Attributes)
+		{
+			VkVertexInputAttributeDescription& attribute = attributeDescriptions.emplace_back();
+			attribute.binding = 0;
+			attribute.location = layoutAttribute.Location;
+			attribute.format = layoutAttribute.Format;
+			attribute.offset = layoutAttribute.Offset;
+		}
+	}
 
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.vertexBindingDescriptionCount = attributeDescriptions.empty() ? 0 : 1;
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
@@ -64,7 +194,7 @@ void VulkanPipeline::Invalidate()
 	// 该管线将图元装配为三角形列表（尽管我们只使用一个三角形）
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
 	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.topology = spec.Topology;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
 
@@ -80,10 +210,10 @@ void VulkanPipeline::Invalidate()
 	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 	rasterizer.depthClampEnable = VK_FALSE;
 	rasterizer.rasterizerDiscardEnable = VK_FALSE;
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.polygonMode = spec.PolygonMode;
 	rasterizer.lineWidth = 1.0f;
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterizer.cullMode = spec.CullMode;
+	rasterizer.frontFace = spec.FrontFace;
 	rasterizer.depthBiasEnable = VK_FALSE;
 	rasterizer.depthBiasConstantFactor = 0.0f; // Optional
 	rasterizer.depthBiasClamp = 0.0f; // Optional
@@ -93,7 +223,7 @@ void VulkanPipeline::Invalidate()
 	VkPipelineMultisampleStateCreateInfo multisampling{};
 	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	multisampling.sampleShadingEnable = VK_FALSE;
-	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisampling.rasterizationSamples = spec.Samples;
 	multisampling.minSampleShading = 1.0f; // Optional
 	multisampling.pSampleMask = nullptr; // Optional
 	multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
@@ -102,13 +232,13 @@ void VulkanPipeline::Invalidate()
 	// 颜色混合
 	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
 	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.blendEnable = VK_FALSE;
-	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
-	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
+	colorBlendAttachment.blendEnable = spec.BlendEnable ? VK_TRUE : VK_FALSE;
+	colorBlendAttachment.srcColorBlendFactor = spec.SrcColorBlendFactor;
+	colorBlendAttachment.dstColorBlendFactor = spec.DstColorBlendFactor;
+	colorBlendAttachment.colorBlendOp = spec.ColorBlendOp;
+	colorBlendAttachment.srcAlphaBlendFactor = spec.SrcAlphaBlendFactor;
+	colorBlendAttachment.dstAlphaBlendFactor = spec.DstAlphaBlendFactor;
+	colorBlendAttachment.alphaBlendOp = spec.AlphaBlendOp;
 	// 颜色混合状态描述如何混合图元的颜色
 	VkPipelineColorBlendStateCreateInfo colorBlending{};
 	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -124,15 +254,15 @@ void VulkanPipeline::Invalidate()
 	// 管线布局
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayouts;
-	pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-	pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(reflection.PushConstantRanges.size());
+	pipelineLayoutInfo.pPushConstantRanges = reflection.PushConstantRanges.data();
 
 	VK_CHECK_RESULT(vkCreatePipelineLayout(VulkanContext::Get()->GetCurrentDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout));
 
 	VulkanPipeline* instance = this;
-	const auto& shaderStages = m_Shader->GetPipelineShaderStageCreateInfos();
+	const auto& shaderStages = spec.Shader->GetPipelineShaderStageCreateInfos();
 
 	VkGraphicsPipelineCreateInfo pipelineInfo = {};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -149,16 +279,116 @@ void VulkanPipeline::Invalidate()
 	pipelineInfo.pDynamicState = &dynamicState;
 	pipelineInfo.layout = m_PipelineLayout;
 
-	pipelineInfo.renderPass = VulkanContext::Get()->GetSwapChain().GetRenderPass();
-	pipelineInfo.subpass = 0;
+	pipelineInfo.renderPass = spec.RenderPass;
+	pipelineInfo.subpass = spec.Subpass;
 
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 	pipelineInfo.basePipelineIndex = -1; // Optional
 
-	VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_Pipeline));
+	VK_CHECK_RESULT(VulkanContext::Get()->GetDevice()->GetPipelineCache().CreateGraphicsPipeline(pipelineInfo, m_Pipeline));
+}
+
+Ref<VulkanPipeline> VulkanPipeline::Create(const PipelineSpecification& specification)
+{
+	bool added = false;
+	Ref<VulkanPipeline> pipeline = GetOrAdd(specification, added);
+	if (added)
+		pipeline->Build();
+	else
+		pipeline->Wait();
+	return pipeline;
+}
+
+Ref<VulkanPipeline> VulkanPipeline::CreateAsync(const PipelineSpecification& specification)
+{
+	bool added = false;
+	Ref<VulkanPipeline> pipeline = GetOrAdd(specification, added);
+	if (added)
+	{
+		// 着色器的编译任务在它构造时就已提交，先于这里出队，工作线程在Build()中等待着色器不会死锁
+		Application::Get().GetThreadPool().Submit([pipeline]() { pipeline->Build(); });
+	}
+	return pipeline;
+}
+
+Ref<VulkanPipeline> VulkanPipeline::GetOrAdd(const PipelineSpecification& specification, bool& outAdded)
+{
+	PipelineSpecification spec = specification;
+	if (!spec.RenderPass)
+		spec.RenderPass = VulkanContext::Get()->GetSwapChain().GetRenderPass();
+
+	uint64_t hash = spec.GetHash();
+	auto& cache = Utils::s_PipelineStateCache;
+
+	// 登记后才创建，同时请求相同管线的线程会等待同一次创建
+	std::scoped_lock lock(cache.Mutex);
+	if (Ref<VulkanPipeline> pipeline = cache.Find(hash, spec))
+	{
+		outAdded = false;
+		return pipeline;
+	}
+
+	Ref<VulkanPipeline> pipeline = CreateRef<VulkanPipeline>(spec);
+	cache.Pipelines[hash].push_back(pipeline);
+	outAdded = true;
+	return pipeline;
+}
+
+void VulkanPipeline::Build()
+{
+	try
+	{
+		Invalidate();
+		m_Ready.store(true, std::memory_order_release);
+	}
+	catch (const std::exception& e)
+	{
+		// 通常是着色器编译失败，使用这个管线的绘制会一直使用后备管线
+		CORE_ERROR("Failed to create pipeline: {0}", e.what());
+	}
+	m_BuildPromise.set_value();
+}
+
+void VulkanPipeline::Wait() const
+{
+	m_BuildFuture.wait();
 }
 
 Ref<VulkanPipeline> VulkanPipeline::Create(Ref<VulkanShader> shader)
 {
-	return CreateRef<VulkanPipeline>(shader);
-}
\ No newline at end of file
+	PipelineSpecification spec;
+	spec.Shader = shader;
+	return Create(spec);
+}
+
+uint32_t VulkanPipeline::GetUniquePipelineCount()
+{
+	auto& cache = Utils::s_PipelineStateCache;
+	std::scoped_lock lock(cache.Mutex);
+
+	uint32_t count = 0;
+	for (const auto& [hash, entries] : cache.Pipelines)
+	{
+		for (const auto& entry : entries)
+			count += entry.expired() ? 0 : 1;
+	}
+	return count;
+}
+
+std::vector<Ref<VulkanPipeline>> VulkanPipeline::GetPipelinesUsingShader(const Ref<VulkanShader>& shader)
+{
+	auto& cache = Utils::s_PipelineStateCache;
+	std::scoped_lock lock(cache.Mutex);
+
+	std::vector<Ref<VulkanPipeline>> pipelines;
+	for (const auto& [hash, entries] : cache.Pipelines)
+	{
+		for (const auto& entry : entries)
+		{
+			Ref<VulkanPipeline> pipeline = entry.lock();
+			if (pipeline && pipeline->GetShader() == shader)
+				pipelines.push_back(pipeline);
+		}
+	}
+	return pipelines;
+}
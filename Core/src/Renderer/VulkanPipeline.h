@@ -3,26 +3,100 @@
 #include "VulkanShader.h"
 #include "VulkanSwapChain.h"
 
+#include <atomic>
+#include <future>
+
+// 顶点缓冲区（绑定0）中的一个属性
+struct VertexAttribute
+{
+	uint32_t Location = 0;
+	VkFormat Format = VK_FORMAT_UNDEFINED;
+	uint32_t Offset = 0;
+};
+
+// Attributes为空时按着色器反射的输入顺序紧密排列
+struct VertexLayout
+{
+	uint32_t Stride = 0;
+	std::vector<VertexAttribute> Attributes;
+};
+
+// 创建一个图形管线所需的全部状态，相同的描述共享同一个管线
+struct PipelineSpecification
+{
+	Ref<VulkanShader> Shader;
+	VertexLayout Layout;
+
+	VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkPolygonMode PolygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags CullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	bool DepthTest = true;
+	bool DepthWrite = true;
+	VkCompareOp DepthCompareOp = VK_COMPARE_OP_LESS;
+
+	// 未启用混合时混合因子不参与比较
+	bool BlendEnable = false;
+	VkBlendFactor SrcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	VkBlendFactor DstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	VkBlendOp ColorBlendOp = VK_BLEND_OP_ADD;
+	VkBlendFactor SrcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	VkBlendFactor DstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	VkBlendOp AlphaBlendOp = VK_BLEND_OP_ADD;
+
+	VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+
+	// 为空时使用交换链的渲染过程；按句柄区分，兼容但不同的渲染过程不会共享管线
+	VkRenderPass RenderPass = nullptr;
+	uint32_t Subpass = 0;
+
+	uint64_t GetHash() const;
+	bool operator==(const PipelineSpecification& other) const;
+};
+
+// 构造时不创建Vulkan对象，通过Create()/CreateAsync()获取
 class VulkanPipeline
 {
 public:
-	VulkanPipeline(Ref<VulkanShader> shader);
+	VulkanPipeline(const PipelineSpecification& specification);
 	~VulkanPipeline();
 
+	// 描述相同且仍在使用的管线直接返回，不会再次创建；线程安全
+	// 阻塞直到管线创建完成（包括等待着色器编译）
+	static Ref<VulkanPipeline> Create(const PipelineSpecification& specification);
 	static Ref<VulkanPipeline> Create(Ref<VulkanShader> shader);
+	// 立即返回，管线在工作线程上创建，IsReady()之前不能绑定
+	static Ref<VulkanPipeline> CreateAsync(const PipelineSpecification& specification);
+	// 当前存活的不同管线数量
+	static uint32_t GetUniquePipelineCount();
+	// 当前存活的使用该着色器的所有管线，着色器热重载时据此重建
+	static std::vector<Ref<VulkanPipeline>> GetPipelinesUsingShader(const Ref<VulkanShader>& shader);
 
 	void Invalidate();
 
+	// 创建完成且成功；着色器编译或管线创建失败时始终为false
+	bool IsReady() const { return m_Ready.load(std::memory_order_acquire); }
+	// 阻塞直到创建结束（无论成功与否）
+	void Wait() const;
+
 	// 获取成员变量
 	VkPipelineLayout GetVulkanPipelineLayout() const { return m_PipelineLayout; }
 	VkPipeline GetVulkanPipeline() { return m_Pipeline; }
-	virtual Ref<VulkanShader> GetShader() const { return m_Shader; }
+	virtual Ref<VulkanShader> GetShader() const { return m_Specification.Shader; }
+	const PipelineSpecification& GetSpecification() const { return m_Specification; }
 private:
+	// 查找或登记描述相同的管线，新登记的管线由调用方负责创建
+	static Ref<VulkanPipeline> GetOrAdd(const PipelineSpecification& specification, bool& outAdded);
+	// 调用Invalidate()并通知等待者，只执行一次
+	void Build();
 private:
-	Ref<VulkanShader> m_Shader;
-	VulkanSwapChain* m_SwapChain;
+	PipelineSpecification m_Specification;
 
 	VkPipeline m_Pipeline = nullptr;
 	VkPipelineLayout m_PipelineLayout = nullptr;
-};
 
+	std::atomic<bool> m_Ready = false;
+	std::promise<void> m_BuildPromise;
+	std::shared_future<void> m_BuildFuture;
+};
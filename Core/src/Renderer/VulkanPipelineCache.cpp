@@ -0,0 +1,196 @@
+#include "pch.h"
+#include "VulkanPipelineCache.h"
+
+#include "VulkanDevice.h"
+
+#include <chrono>
+
+VulkanPipelineCache::VulkanPipelineCache(VkDevice device, const Ref<VulkanPhysicalDevice>& physicalDevice, const std::filesystem::path& filepath, bool creationFeedbackSupported)
+	: m_Device(device), m_PhysicalDevice(physicalDevice), m_Filepath(filepath), m_CreationFeedbackSupported(creationFeedbackSupported)
+{
+	std::vector<uint8_t> data = Load();
+	if (!data.empty() && !IsCompatible(data))
+	{
+		CORE_WARN("Pipeline cache '{0}' was created by a different device or driver, discarding", m_Filepath.string());
+		data.clear();
+	}
+
+	VkPipelineCacheCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	// 驱动仍可能拒绝通过了文件头检查的数据，此时退回空缓存
+	VkResult result = vkCreatePipelineCache(m_Device, &createInfo, nullptr, &m_PipelineCache);
+	if (result != VK_SUCCESS && !data.empty())
+	{
+		CORE_WARN("Driver rejected pipeline cache '{0}', starting cold", m_Filepath.string());
+		data.clear();
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(m_Device, &createInfo, nullptr, &m_PipelineCache);
+	}
+	VK_CHECK_RESULT(result);
+
+	m_Stats.LoadedFromDisk = !data.empty();
+	CORE_INFO("Pipeline cache: {0} ({1} bytes from '{2}')", m_Stats.LoadedFromDisk ? "warm" : "cold", data.size(), m_Filepath.string());
+}
+
+VulkanPipelineCache::~VulkanPipelineCache()
+{
+}
+
+void VulkanPipelineCache::Destroy()
+{
+	if (!m_PipelineCache)
+		return;
+
+	Save();
+
+	auto stats = GetStats();
+	CORE_INFO("Pipeline cache: {0} start, created {1} pipelines in {2:.2f} ms, {3} cache hits",
+		stats.LoadedFromDisk ? "warm" : "cold", stats.PipelinesCreated, stats.TotalCreateTimeMs, stats.CacheHits);
+
+	vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+	m_PipelineCache = nullptr;
+}
+
+VkResult VulkanPipelineCache::CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline& outPipeline)
+{
+	VkGraphicsPipelineCreateInfo pipelineInfo = createInfo;
+	return CreatePipeline(pipelineInfo, pipelineInfo.stageCount, "graphics", [&]()
+	{
+		return vkCreateGraphicsPipelines(m_Device, m_PipelineCache, 1, &pipelineInfo, nullptr, &outPipeline);
+	});
+}
+
+VkResult VulkanPipelineCache::CreateComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline& outPipeline)
+{
+	VkComputePipelineCreateInfo pipelineInfo = createInfo;
+	return CreatePipeline(pipelineInfo, 1, "compute", [&]()
+	{
+		return vkCreateComputePipelines(m_Device, m_PipelineCache, 1, &pipelineInfo, nullptr, &outPipeline);
+	});
+}
+
+template<typename TCreateInfo, typename TCreateFunc>
+VkResult VulkanPipelineCache::CreatePipeline(TCreateInfo& pipelineInfo, uint32_t stageCount, const char* kind, TCreateFunc&& create)
+{
+	// 创建反馈可以告诉我们这次是否命中了缓存
+	VkPipelineCreationFeedbackEXT feedback{};
+	std::vector<VkPipelineCreationFeedbackEXT> stageFeedbacks(stageCount);
+	VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+	if (m_CreationFeedbackSupported)
+	{
+		feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+		feedbackInfo.pNext = pipelineInfo.pNext;
+		feedbackInfo.pPipelineCreationFeedback = &feedback;
+		feedbackInfo.pipelineStageCreationFeedbackCount = stageCount;
+		feedbackInfo.pPipelineStageCreationFeedbacks = stageFeedbacks.data();
+		pipelineInfo.pNext = &feedbackInfo;
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	VkResult result = create();
+	auto endTime = std::chrono::high_resolution_clock::now();
+	if (result != VK_SUCCESS)
+		return result;
+
+	float timeMs = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+	bool feedbackValid = m_CreationFeedbackSupported && (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT);
+	bool cacheHit = feedbackValid && (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT);
+
+	{
+		std::scoped_lock lock(m_Mutex);
+		m_Stats.PipelinesCreated++;
+		m_Stats.TotalCreateTimeMs += timeMs;
+		if (cacheHit)
+			m_Stats.CacheHits++;
+	}
+
+	if (feedbackValid)
+		CORE_INFO("Created {0} pipeline in {1:.2f} ms (cache {2})", kind, timeMs, cacheHit ? "hit" : "miss");
+	else
+		CORE_INFO("Created {0} pipeline in {1:.2f} ms ({2} cache)", kind, timeMs, m_Stats.LoadedFromDisk ? "warm" : "cold");
+
+	return result;
+}
+
+VulkanPipelineCacheStats VulkanPipelineCache::GetStats() const
+{
+	std::scoped_lock lock(m_Mutex);
+	return m_Stats;
+}
+
+std::vector<uint8_t> VulkanPipelineCache::Load() const
+{
+	std::ifstream file(m_Filepath, std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+		return {};
+
+	size_t fileSize = (size_t)file.tellg();
+	std::vector<uint8_t> data(fileSize);
+	file.seekg(0);
+	file.read((char*)data.data(), fileSize);
+	if (!file)
+		return {};
+
+	return data;
+}
+
+bool VulkanPipelineCache::IsCompatible(const std::vector<uint8_t>& data) const
+{
+	// 文件头布局见VkPipelineCacheHeaderVersionOne
+	struct PipelineCacheHeader
+	{
+		uint32_t HeaderSize;
+		uint32_t HeaderVersion;
+		uint32_t VendorID;
+		uint32_t DeviceID;
+		uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+	};
+
+	if (data.size() < sizeof(PipelineCacheHeader))
+		return false;
+
+	PipelineCacheHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+
+	const auto& properties = m_PhysicalDevice->GetProperties();
+	return header.HeaderSize >= sizeof(PipelineCacheHeader)
+		&& header.HeaderVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		&& header.VendorID == properties.vendorID
+		&& header.DeviceID == properties.deviceID
+		&& memcmp(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void VulkanPipelineCache::Save() const
+{
+	size_t dataSize = 0;
+	VK_CHECK_RESULT(vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, nullptr));
+	std::vector<uint8_t> data(dataSize);
+	VK_CHECK_RESULT(vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, data.data()));
+	if (dataSize == 0)
+		return;
+
+	std::error_code error;
+	if (m_Filepath.has_parent_path())
+		std::filesystem::create_directories(m_Filepath.parent_path(), error);
+
+	// 先写临时文件再替换，避免中途退出留下损坏的缓存
+	std::filesystem::path tempPath = m_Filepath;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			CORE_WARN("Failed to write pipeline cache '{0}'", tempPath.string());
+			return;
+		}
+		file.write((const char*)data.data(), dataSize);
+	}
+
+	std::filesystem::rename(tempPath, m_Filepath, error);
+	if (error)
+		CORE_WARN("Failed to write pipeline cache '{0}': {1}", m_Filepath.string(), error.message());
+}
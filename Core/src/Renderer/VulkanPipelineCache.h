@@ -0,0 +1,51 @@
+#pragma once
+#include "Vulkan.h"
+
+#include <mutex>
+
+class VulkanPhysicalDevice;
+
+struct VulkanPipelineCacheStats
+{
+	bool LoadedFromDisk = false;		// 启动时是否读取到有效的缓存文件
+	uint32_t PipelinesCreated = 0;
+	uint32_t CacheHits = 0;				// 需要VK_EXT_pipeline_creation_feedback，不支持时始终为0
+	float TotalCreateTimeMs = 0.0f;
+};
+
+// 管线缓存
+// 启动时从磁盘读取，文件头的厂商ID、设备ID与pipelineCacheUUID必须与当前设备一致，否则丢弃重新开始；
+// 设备销毁时写回磁盘。所有管线都应通过这里创建，以便统计冷/热启动的耗时
+class VulkanPipelineCache
+{
+public:
+	VulkanPipelineCache(VkDevice device, const Ref<VulkanPhysicalDevice>& physicalDevice, const std::filesystem::path& filepath, bool creationFeedbackSupported);
+	~VulkanPipelineCache();
+
+	// 写回磁盘并销毁缓存对象
+	void Destroy();
+
+	VkResult CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline& outPipeline);
+	VkResult CreateComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline& outPipeline);
+
+	VkPipelineCache GetVulkanPipelineCache() const { return m_PipelineCache; }
+	VulkanPipelineCacheStats GetStats() const;
+private:
+	// 在pipelineInfo的pNext链上挂接创建反馈，调用create创建管线并记录统计
+	template<typename TCreateInfo, typename TCreateFunc>
+	VkResult CreatePipeline(TCreateInfo& pipelineInfo, uint32_t stageCount, const char* kind, TCreateFunc&& create);
+
+	std::vector<uint8_t> Load() const;
+	bool IsCompatible(const std::vector<uint8_t>& data) const;
+	void Save() const;
+private:
+	VkDevice m_Device = nullptr;
+	Ref<VulkanPhysicalDevice> m_PhysicalDevice;
+	std::filesystem::path m_Filepath;
+	bool m_CreationFeedbackSupported = false;
+
+	VkPipelineCache m_PipelineCache = nullptr;
+
+	VulkanPipelineCacheStats m_Stats;
+	mutable std::mutex m_Mutex;
+};
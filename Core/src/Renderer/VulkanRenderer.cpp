@@ -5,18 +5,72 @@
 #include "VulkanContext.h"
 #include "Data/Vertex.h"
 
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
 #include "VulkanTexture.h"
+#include "VulkanUploadBatch.h"
+
+#include <chrono>
+#include <mutex>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
+// 每次绘制的推送常量，布局与着色器中的PushConstants块一致
+// 顶点阶段使用[0, 64)，bindless片段着色器使用[64, 68)
+struct DrawPushConstants
+{
+	glm::mat4 Model;
+	uint32_t TextureIndex;
+};
+
+// 绘制列表中的一次绘制
+struct DrawCommand
+{
+	VkBuffer VertexBuffer = nullptr;
+	VkBuffer IndexBuffer = nullptr;
+	uint32_t IndexCount = 0;
+	uint32_t FirstIndex = 0;
+	int32_t VertexOffset = 0;
+	// 为空时使用渲染器的默认管线
+	Ref<VulkanPipeline> Pipeline;
+	// bindless模式下纹理在全局描述符集中的索引
+	uint32_t TextureIndex = 0;
+	// 与TextureIndex一起通过推送常量传给着色器
+	glm::mat4 Transform = glm::mat4(1.0f);
+};
+
 struct VulkanRendererData
 {
 	Ref<VulkanVertexBuffer> VertexBuffer;
 	Ref<VulkanIndexBuffer> IndexBuffer;
 	Ref<VulkanUniformBuffer> UniformBuffer;
 
-	VulkanShader::ShaderDescriptorSet shaderDescriptorSet;
+	Ref<VulkanUploadHandle> UploadHandle;		// 初始化资源的上传
+
+	std::vector<DrawCommand> DrawList;
+
+	VkDescriptorSet FrameDescriptorSet = nullptr;	// 当前帧的描述符集，来自描述符集缓存
+	uint32_t FrameUniformOffset = 0;				// 本帧uniform数据在帧uniform区间中的动态偏移
+	glm::mat4 ModelRotation = glm::mat4(1.0f);		// 示例模型的旋转，录制时与每个绘制的变换相乘
+
+	// 绘制使用的管线仍在编译时改用后备管线，未设置时跳过这些绘制
+	Ref<VulkanPipeline> FallbackPipeline;
+
+	uint32_t TextureIndex = VulkanBindlessDescriptors::InvalidIndex;
+
+	// 示例模型的纹理在工作线程上解码，上传完成后模型才加入绘制列表，之前的帧只清屏
+	TextureLoader Loader;
+	Ref<TextureLoadHandle> ModelTextureLoad;
+	DrawCommand ModelDraw;
+
+	// 流式纹理调入或驱逐后换了图像视图，bindless模式下据此重新注册
+	TextureStreamer Streamer;
+	VkImageView TextureView = nullptr;
+
+	// 着色器热重载后重建的管线（旧管线, 新管线），由渲染线程在帧开始时替换
+	std::vector<std::pair<Ref<VulkanPipeline>, Ref<VulkanPipeline>>> PendingPipelines;
+	std::mutex PipelineReloadMutex;
 };
 
 // 临时数据
@@ -33,6 +87,7 @@ void VulkanRenderer::Init(Ref<VulkanPipeline> pipeline)
 	m_Pipeline = pipeline;
 
 	s_Data = new VulkanRendererData();
+	s_Data->FallbackPipeline = pipeline;
 
 	// 加载模型数据
 	const std::string MODEL_PATH = "models/viking_room.obj";
@@ -75,62 +130,46 @@ void VulkanRenderer::Init(Ref<VulkanPipeline> pipeline)
 		}
 	}
 
-	// 创建缓冲区
-	s_Data->VertexBuffer = VulkanVertexBuffer::Create((void*)vertices.data(), sizeof(vertices[0]) * vertices.size());
-	s_Data->IndexBuffer = VulkanIndexBuffer::Create((void*)indices.data(), indices.size() * sizeof(indices[0]));
+	// 创建缓冲区，所有静态资源的上传合并为一次提交
+	VulkanUploadBatch uploadBatch;
+	s_Data->VertexBuffer = VulkanVertexBuffer::Create((void*)vertices.data(), sizeof(vertices[0]) * vertices.size(), &uploadBatch);
+	s_Data->IndexBuffer = VulkanIndexBuffer::Create((void*)indices.data(), indices.size() * sizeof(indices[0]), &uploadBatch);
 	s_Data->UniformBuffer = VulkanUniformBuffer::Create(); 
 
-	TextureSpecification textureSpec;
-	m_Texture = VulkanTexture::Create(textureSpec, TEXTURE_PATH);
+	// 绘制命令提交在同一队列上，会在上传之后执行，这里无需等待
+	s_Data->UploadHandle = uploadBatch.Submit();
 
-	uint32_t framesInFlight = VulkanContext::Get()->GetConfig().FramesInFlight; // 获取最大飞行帧数
-
-	auto shader = pipeline->GetShader();
+	// 先显示mip尾部，高级别按窗口大小调入
+	TextureSpecification textureSpec;
+	textureSpec.Streaming = true;
+	s_Data->ModelTextureLoad = s_Data->Loader.Load(textureSpec, TEXTURE_PATH);
 
-	s_Data->shaderDescriptorSet = shader->CreateDescriptorSets(); // 创建描述符集
+	s_Data->ModelDraw.VertexBuffer = s_Data->VertexBuffer->GetVulkanBuffer();
+	s_Data->ModelDraw.IndexBuffer = s_Data->IndexBuffer->GetVulkanBuffer();
+	s_Data->ModelDraw.IndexCount = static_cast<uint32_t>(indices.size());
 
-	VkDescriptorSetLayout descriptorSetLayout = shader->GetDescriptorSetLayout(); // 获取描述符布局
+	// 并行录制时每个分段使用各飞行帧中的一个二级命令缓冲区，分段数不超过工作线程数
+	auto& swapChain = Application::Get().GetWindow().GetSwapChain();
+	uint32_t threadCount = Application::Get().GetThreadPool().GetThreadCount();
+	for (uint32_t i = 0; i < swapChain.GetFrameContextCount(); i++)
+		swapChain.GetFrameContext(i).ReserveSecondaryCommandBuffers(threadCount);
 
-	std::vector<VkBuffer> uniformBuffer = s_Data->UniformBuffer->GetVulkanBuffer();
-	for (size_t i = 0; i < framesInFlight; i++)
+	Application::Get().GetShaderLibrary().AddReloadCallback([](const std::string& name, const Ref<VulkanShader>& oldShader, const Ref<VulkanShader>& newShader)
 	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = uniformBuffer[i];
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(UniformBufferObject);
-
-		VkDescriptorImageInfo imageInfo{};
-		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imageInfo.imageView = m_Texture->GetImageView();
-		imageInfo.sampler = m_Texture->GetSampler();
-		
-		std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
-		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[0].dstSet = s_Data->shaderDescriptorSet.DescriptorSets[i];
-		descriptorWrites[0].dstBinding = 0;
-		descriptorWrites[0].dstArrayElement = 0;
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrites[0].descriptorCount = 1;
-		descriptorWrites[0].pBufferInfo = &bufferInfo;
-
-		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[1].dstSet = s_Data->shaderDescriptorSet.DescriptorSets[i];
-		descriptorWrites[1].dstBinding = 1;
-		descriptorWrites[1].dstArrayElement = 0;
-		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrites[1].descriptorCount = 1;
-		descriptorWrites[1].pImageInfo = &imageInfo;
-
-		vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-	}
+		OnShaderReloaded(oldShader, newShader);
+	});
 }
 
 void VulkanRenderer::Shutdown()
 {
 	auto device = VulkanContext::Get()->GetCurrentDevice();
 
-	vkDestroyDescriptorPool(device, s_Data->shaderDescriptorSet.Pool, nullptr);
-	
+	// 等待仍在飞行中的帧使用完资源
+	vkDeviceWaitIdle(device);
+
+	if (s_Data->TextureIndex != VulkanBindlessDescriptors::InvalidIndex)
+		VulkanContext::Get()->GetDevice()->GetBindlessDescriptors()->UnregisterTexture(s_Data->TextureIndex);
+
 	m_Texture.reset(); // 显式释放纹理资源
 
 	delete s_Data;
@@ -141,6 +180,10 @@ void VulkanRenderer::DrawFrame()
 	auto& swapChain = Application::Get().GetWindow().GetSwapChain();
 
 	swapChain.BeginFrame();
+	ApplyPendingPipeline();
+	ApplyLoadedTextures();
+	StreamTextures();
+	UpdateFrameUniforms();
 	
 	// 获取当前帧的命令缓冲区
 	VkCommandBuffer commandBuffer = swapChain.GetCurrentDrawCommandBuffer();
@@ -152,22 +195,23 @@ void VulkanRenderer::DrawFrame()
 	cmdBufInfo.pNext = nullptr;
 	VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &cmdBufInfo));
 	
-	// 开始渲染过程
-	BeginRenderPass(s_Renderer->m_Pipeline);
+	// 绘制数量足够多时分散到工作线程录制二级命令缓冲区
+	const auto& config = VulkanContext::Get()->GetConfig();
+	uint32_t drawCount = static_cast<uint32_t>(s_Data->DrawList.size());
+	bool parallel = config.ParallelRecording && drawCount >= config.ParallelRecordingMinDrawsPerThread * 2;
 
-	VkBuffer vertexBuffers[] = { s_Data->VertexBuffer->GetVulkanBuffer() };
-	VkBuffer indexBuffer = s_Data->IndexBuffer->GetVulkanBuffer();
-	VkDeviceSize offsets[] = { 0 };
-
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-
-	// 绑定描述符集
-	auto pipelineLayout = s_Renderer->m_Pipeline->GetVulkanPipelineLayout();
-	std::vector<VkDescriptorSet> descriptorSets = s_Data->shaderDescriptorSet.DescriptorSets;
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[swapChain.GetCurrentImageIndex()], 0, nullptr);
+	if (parallel)
+	{
+		BeginRenderPass(s_Renderer->m_Pipeline, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+		std::vector<VkCommandBuffer> secondaryCommandBuffers = RecordDrawsParallel();
+		vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+	}
+	else
+	{
+		BeginRenderPass(s_Renderer->m_Pipeline);
+		RecordDraws(commandBuffer, 0, drawCount);
+	}
 	
 	// 结束渲染过程
 	EndRenderPass(commandBuffer);
@@ -176,13 +220,11 @@ void VulkanRenderer::DrawFrame()
 	swapChain.Present();
 }
 
-void VulkanRenderer::BeginRenderPass(Ref<VulkanPipeline> pipeline)
+void VulkanRenderer::BeginRenderPass(Ref<VulkanPipeline> pipeline, VkSubpassContents contents)
 {
 	auto& swapChain = Application::Get().GetWindow().GetSwapChain();
 	VkCommandBuffer commandBuffer = swapChain.GetCurrentDrawCommandBuffer();
 
-	s_Data->UniformBuffer->UpdateUniformBuffer(swapChain.GetCurrentImageIndex());
-
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -200,7 +242,15 @@ void VulkanRenderer::BeginRenderPass(Ref<VulkanPipeline> pipeline)
 	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassInfo.pClearValues = clearValues.data();
 
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+
+	if (contents == VK_SUBPASS_CONTENTS_INLINE)
+		BindPipelineState(commandBuffer, pipeline);
+}
+
+void VulkanRenderer::BindPipelineState(VkCommandBuffer commandBuffer, Ref<VulkanPipeline> pipeline)
+{
+	auto& swapChain = Application::Get().GetWindow().GetSwapChain();
 
 	// 设置动态视口和剪裁区域
 	VkViewport viewport{};
@@ -217,9 +267,285 @@ void VulkanRenderer::BeginRenderPass(Ref<VulkanPipeline> pipeline)
 	scissor.extent = swapChain.GetSwapChainExtent();
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-	// 绑定 Vulkan Pipeline
-	VkPipeline vulkanPipeline = pipeline->GetVulkanPipeline();
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkanPipeline);
+	// 绑定 Vulkan Pipeline，未就绪的管线由RecordDraws()按绘制换成后备管线
+	if (pipeline->IsReady())
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->GetVulkanPipeline());
+}
+
+void VulkanRenderer::RecordDraws(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end)
+{
+	// BindPipelineState()已绑定默认管线
+	VulkanPipeline* boundPipeline = s_Renderer->m_Pipeline->IsReady() ? s_Renderer->m_Pipeline.get() : nullptr;
+	VkPipelineLayout boundLayout = nullptr;
+
+	// bindless模式下set 1是全局描述符集，与帧描述符集一起绑定，之后不随纹理变化
+	auto* bindless = VulkanContext::Get()->GetDevice()->GetBindlessDescriptors();
+	std::array<VkDescriptorSet, 2> descriptorSets = { s_Data->FrameDescriptorSet, bindless ? bindless->GetDescriptorSet() : nullptr };
+	uint32_t descriptorSetCount = bindless ? 2 : 1;
+	uint32_t pushedTextureIndex = VulkanBindlessDescriptors::InvalidIndex;
+	// set 0只有一个动态uniform缓冲区
+	uint32_t uniformOffset = s_Data->FrameUniformOffset;
+
+	VkBuffer boundVertexBuffer = nullptr;
+	VkBuffer boundIndexBuffer = nullptr;
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const DrawCommand& draw = s_Data->DrawList[i];
+
+		VulkanPipeline* pipeline = GetDrawPipeline(draw);
+		if (!pipeline)
+			continue;
+
+		if (pipeline != boundPipeline)
+		{
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->GetVulkanPipeline());
+			boundPipeline = pipeline;
+		}
+
+		// 描述符集按默认管线的set 0布局分配，绘制使用的管线需与之兼容
+		if (pipeline->GetVulkanPipelineLayout() != boundLayout)
+		{
+			boundLayout = pipeline->GetVulkanPipelineLayout();
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundLayout, 0, descriptorSetCount, descriptorSets.data(), 1, &uniformOffset);
+			pushedTextureIndex = VulkanBindlessDescriptors::InvalidIndex;
+		}
+
+		// 变换每次绘制都不同，直接写入命令缓冲区，不经过uniform缓冲区和描述符
+		DrawPushConstants pushConstants;
+		pushConstants.Model = s_Data->ModelRotation * draw.Transform;
+		pushConstants.TextureIndex = draw.TextureIndex;
+		vkCmdPushConstants(commandBuffer, boundLayout, VK_SHADER_STAGE_VERTEX_BIT, offsetof(DrawPushConstants, Model), sizeof(glm::mat4), &pushConstants.Model);
+
+		if (bindless && draw.TextureIndex != pushedTextureIndex)
+		{
+			vkCmdPushConstants(commandBuffer, boundLayout, VK_SHADER_STAGE_FRAGMENT_BIT, offsetof(DrawPushConstants, TextureIndex), sizeof(uint32_t), &pushConstants.TextureIndex);
+			pushedTextureIndex = draw.TextureIndex;
+		}
+
+		// 相邻绘制共用缓冲区时跳过重复绑定
+		if (draw.VertexBuffer != boundVertexBuffer)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.VertexBuffer, &offset);
+			boundVertexBuffer = draw.VertexBuffer;
+		}
+		if (draw.IndexBuffer != boundIndexBuffer)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, draw.IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			boundIndexBuffer = draw.IndexBuffer;
+		}
+
+		vkCmdDrawIndexed(commandBuffer, draw.IndexCount, 1, draw.FirstIndex, draw.VertexOffset, 0);
+	}
+}
+
+VulkanPipeline* VulkanRenderer::GetDrawPipeline(const DrawCommand& draw)
+{
+	VulkanPipeline* pipeline = draw.Pipeline ? draw.Pipeline.get() : s_Renderer->m_Pipeline.get();
+	if (pipeline->IsReady())
+		return pipeline;
+
+	// 编译完成后的下一帧自动换上真正的管线
+	VulkanPipeline* fallback = s_Data->FallbackPipeline.get();
+	return fallback && fallback->IsReady() ? fallback : nullptr;
+}
+
+void VulkanRenderer::SetFallbackPipeline(Ref<VulkanPipeline> pipeline)
+{
+	s_Data->FallbackPipeline = pipeline;
+}
+
+std::vector<VkCommandBuffer> VulkanRenderer::RecordDrawsParallel()
+{
+	auto& swapChain = Application::Get().GetWindow().GetSwapChain();
+	auto& threadPool = Application::Get().GetThreadPool();
+	auto& frame = swapChain.GetCurrentFrameContext();
+
+	uint32_t drawCount = static_cast<uint32_t>(s_Data->DrawList.size());
+	uint32_t minDrawsPerThread = VulkanContext::Get()->GetConfig().ParallelRecordingMinDrawsPerThread;
+
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = swapChain.GetRenderPass();
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = swapChain.GetCurrentFramebuffer();
+
+	std::vector<VkCommandBuffer> recorded(threadPool.GetThreadCount(), nullptr);
+	threadPool.ParallelFor(drawCount, minDrawsPerThread, [&](uint32_t begin, uint32_t end, uint32_t chunk)
+	{
+		// 帧上下文在BeginFrame中已重置
+		VkCommandBuffer secondary = frame.GetSecondaryCommandBuffer(chunk);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(secondary, &beginInfo));
+
+		BindPipelineState(secondary, s_Renderer->m_Pipeline);
+		RecordDraws(secondary, begin, end);
+
+		VK_CHECK_RESULT(vkEndCommandBuffer(secondary));
+		recorded[chunk] = secondary;
+	});
+
+	// 保持分段顺序，与内联录制的绘制顺序一致
+	std::erase(recorded, nullptr);
+	return recorded;
+}
+
+void VulkanRenderer::UpdateFrameUniforms()
+{
+	auto& swapChain = Application::Get().GetWindow().GetSwapChain();
+	auto& frame = swapChain.GetCurrentFrameContext();
+	auto vkDevice = VulkanContext::Get()->GetDevice();
+
+	// 示例模型绕z轴旋转
+	static auto startTime = std::chrono::high_resolution_clock::now();
+	auto currentTime = std::chrono::high_resolution_clock::now();
+	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+	s_Data->ModelRotation = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+	// uniform中只有每帧不变的数据，每个绘制的变换在录制时推送
+	s_Data->FrameUniformOffset = s_Data->UniformBuffer->Update(frame);
+
+	Ref<VulkanShader> shader = s_Renderer->m_Pipeline->GetShader();
+	DescriptorSetDescription description;
+	description.Layout = shader->GetDescriptorSetLayout(ShaderReflection::FrameUniformSet);
+	description.AddBuffer(ShaderReflection::FrameUniformBinding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, s_Data->UniformBuffer->GetDescriptorBufferInfo());
+
+	// bindless模式下纹理来自全局描述符集，帧描述符集中只有uniform；纹理未就绪时没有绘制会用到它
+	// 非bindless着色器的纹理绑定位置由反射得到
+	if (!vkDevice->GetBindlessDescriptors() && s_Renderer->m_Texture)
+	{
+		uint32_t textureBinding = shader->GetReflection().FindBinding(ShaderReflection::FrameUniformSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		CORE_ASSERT(textureBinding != UINT32_MAX, "Shader has no combined image sampler in the frame descriptor set!");
+		description.AddImage(textureBinding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, s_Renderer->m_Texture->GetImageView(), s_Renderer->m_Texture->GetSampler());
+	}
+
+	// 描述符只引用帧uniform缓冲区的基址，每个飞行帧的集合第一次创建后一直命中缓存
+	s_Data->FrameDescriptorSet = vkDevice->GetDescriptorSetCache().Get(description);
+}
+
+void VulkanRenderer::ApplyLoadedTextures()
+{
+	s_Data->Loader.Update();
+
+	if (!s_Data->ModelTextureLoad || !s_Data->ModelTextureLoad->IsReady())
+		return;
+
+	s_Renderer->m_Texture = s_Data->ModelTextureLoad->GetTexture();
+	s_Data->ModelTextureLoad.reset();
+	// 加载失败时错误已由加载器输出，模型不再绘制
+	if (!s_Renderer->m_Texture)
+		return;
+
+	// bindless模式下纹理只注册一次，之后每次绘制只需推送索引
+	if (auto* bindless = VulkanContext::Get()->GetDevice()->GetBindlessDescriptors())
+		s_Data->TextureIndex = bindless->RegisterTexture(s_Renderer->m_Texture->GetImageView(), s_Renderer->m_Texture->GetSampler());
+	s_Data->TextureView = s_Renderer->m_Texture->GetImageView();
+
+	s_Data->ModelDraw.TextureIndex = s_Data->TextureIndex;
+	s_Data->DrawList.push_back(s_Data->ModelDraw);
+}
+
+void VulkanRenderer::StreamTextures()
+{
+	auto& swapChain = Application::Get().GetWindow().GetSwapChain();
+	const Ref<VulkanTexture>& texture = s_Renderer->m_Texture;
+
+	// 示例模型大致占满窗口，按窗口较长边请求
+	if (texture)
+	{
+		VkExtent2D extent = swapChain.GetSwapChainExtent();
+		s_Data->Streamer.Request(texture, std::max(extent.width, extent.height));
+	}
+
+	s_Data->Streamer.Update();
+
+	// 非bindless模式下帧描述符集每帧按当前视图从缓存中取得，无需处理
+	auto* bindless = VulkanContext::Get()->GetDevice()->GetBindlessDescriptors();
+	if (!bindless || !texture || texture->GetImageView() == s_Data->TextureView)
+		return;
+
+	// 飞行中的帧仍在使用旧索引处的描述符，不能原地改写：注册到新索引，旧索引在本帧完成后注销
+	uint32_t oldIndex = s_Data->TextureIndex;
+	s_Data->TextureIndex = bindless->RegisterTexture(texture->GetImageView(), texture->GetSampler());
+	s_Data->TextureView = texture->GetImageView();
+
+	for (auto& draw : s_Data->DrawList)
+	{
+		if (draw.TextureIndex == oldIndex)
+			draw.TextureIndex = s_Data->TextureIndex;
+	}
+	swapChain.GetCurrentFrameContext().DeferRelease([bindless, oldIndex]() { bindless->UnregisterTexture(oldIndex); });
+}
+
+void VulkanRenderer::OnShaderReloaded(const Ref<VulkanShader>& oldShader, const Ref<VulkanShader>& newShader)
+{
+	// 包括后备管线、绘制命令各自的管线和尚未换上的待替换管线
+	std::vector<Ref<VulkanPipeline>> oldPipelines = VulkanPipeline::GetPipelinesUsingShader(oldShader);
+	if (oldPipelines.empty())
+		return;
+
+	// 其余状态不变，只替换着色器；管线在工作线程上并行创建，调用线程等待，渲染循环不会卡顿
+	std::vector<Ref<VulkanPipeline>> newPipelines;
+	for (const auto& pipeline : oldPipelines)
+	{
+		PipelineSpecification spec = pipeline->GetSpecification();
+		spec.Shader = newShader;
+		newPipelines.push_back(VulkanPipeline::CreateAsync(spec));
+	}
+	for (const auto& pipeline : newPipelines)
+		pipeline->Wait();
+
+	std::scoped_lock lock(s_Data->PipelineReloadMutex);
+	for (size_t i = 0; i < oldPipelines.size(); i++)
+	{
+		if (!newPipelines[i]->IsReady())
+			continue;
+
+		// 上一次重载的管线还没换上时，直接替换那一项；被覆盖的待替换管线从未被录制，可以直接释放
+		auto it = std::find_if(s_Data->PendingPipelines.begin(), s_Data->PendingPipelines.end(),
+			[&](const auto& pending) { return pending.second == oldPipelines[i]; });
+		if (it != s_Data->PendingPipelines.end())
+			it->second = newPipelines[i];
+		else
+			s_Data->PendingPipelines.emplace_back(oldPipelines[i], newPipelines[i]);
+	}
+}
+
+void VulkanRenderer::ApplyPendingPipeline()
+{
+	std::vector<std::pair<Ref<VulkanPipeline>, Ref<VulkanPipeline>>> pendingPipelines;
+	{
+		std::scoped_lock lock(s_Data->PipelineReloadMutex);
+		if (s_Data->PendingPipelines.empty())
+			return;
+		pendingPipelines.swap(s_Data->PendingPipelines);
+	}
+
+	// 渲染器持有的所有管线引用都要替换，否则旧管线会一直被使用；渲染器之外的持有者需要用新着色器重新获取
+	auto replace = [&pendingPipelines](Ref<VulkanPipeline>& pipeline)
+	{
+		for (const auto& [oldPipeline, newPipeline] : pendingPipelines)
+		{
+			if (pipeline == oldPipeline)
+			{
+				pipeline = newPipeline;
+				return;
+			}
+		}
+	};
+	replace(s_Renderer->m_Pipeline);
+	replace(s_Data->FallbackPipeline);
+	replace(s_Data->ModelDraw.Pipeline);
+	for (auto& draw : s_Data->DrawList)
+		replace(draw.Pipeline);
+
+	// 当前帧上下文下次重置时，包括本帧在内的所有更早的帧都已执行完毕
+	auto& frame = Application::Get().GetWindow().GetSwapChain().GetCurrentFrameContext();
+	frame.DeferRelease([pendingPipelines]() mutable { pendingPipelines.clear(); });
 }
 
 void VulkanRenderer::EndRenderPass(VkCommandBuffer commandBuffer)
@@ -7,6 +7,8 @@
 #include "Buffer/VulkanUniformBuffer.h"
 #include "VulkanTexture.h"
 
+struct DrawCommand;
+
 class VulkanRenderer
 {
 public:
@@ -15,9 +17,33 @@ public:
 
 	static void DrawFrame();
 
-	static void BeginRenderPass(Ref<VulkanPipeline> pipeline);
+	// contents为SECONDARY_COMMAND_BUFFERS时只开始渲染过程，绘制状态由二级命令缓冲区设置
+	static void BeginRenderPass(Ref<VulkanPipeline> pipeline, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 	static void EndRenderPass(VkCommandBuffer commandBuffer);
 
+	// 绘制使用的管线尚未编译完成时代替它，为空时跳过这些绘制；默认为初始化时传入的管线
+	static void SetFallbackPipeline(Ref<VulkanPipeline> pipeline);
+
+private:
+	static void BindPipelineState(VkCommandBuffer commandBuffer, Ref<VulkanPipeline> pipeline);
+	// 录制绘制列表中[begin, end)范围的绘制
+	static void RecordDraws(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end);
+	// 绘制列表分段由工作线程和渲染线程录制到二级命令缓冲区，返回录制好的命令缓冲区
+	static std::vector<VkCommandBuffer> RecordDrawsParallel();
+	// 绘制实际使用的管线：未就绪时为后备管线，都不可用时为空
+	static VulkanPipeline* GetDrawPipeline(const DrawCommand& draw);
+
+	// 上传加载完成的纹理，示例模型的纹理就绪后加入绘制列表
+	static void ApplyLoadedTextures();
+	// 请求示例模型纹理需要的级别并执行调入与驱逐
+	static void StreamTextures();
+	// 写入本帧的uniform数据并取得本帧使用的描述符集
+	static void UpdateFrameUniforms();
+
+	// 在监视线程上调用：所有使用旧着色器的存活管线在后台重建，等待下一帧替换
+	static void OnShaderReloaded(const Ref<VulkanShader>& oldShader, const Ref<VulkanShader>& newShader);
+	// 帧开始时替换渲染器持有的所有旧管线，旧管线延迟到不再被飞行中的帧使用后释放
+	static void ApplyPendingPipeline();
 private:
 	Ref<VulkanPipeline> m_Pipeline;
 	Ref<VulkanTexture> m_Texture;
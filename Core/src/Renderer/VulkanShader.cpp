@@ -4,41 +4,126 @@
 #include <shaderc/shaderc.hpp>
 
 #include "VulkanContext.h"
+#include "Application.h"
 
 VulkanShader::VulkanShader(const std::string& vertShaderPath, const std::string& fragShaderPath)
+    : m_VertShaderPath(vertShaderPath), m_FragShaderPath(fragShaderPath)
 {
-    // 在构造函数中调用ReadShader来读取和编译着色器
-    auto vertShaderModule = ReadShader(vertShaderPath, 0); // 0表示顶点着色器
-    auto fragShaderModule = ReadShader(fragShaderPath, 1); // 1表示片段着色器
+    // 各阶段在工作线程上并行读取缓存或编译并反射，管线真正需要着色器时才等待
+    auto& threadPool = Application::Get().GetThreadPool();
+    m_Stages.push_back({ VK_SHADER_STAGE_VERTEX_BIT, threadPool.Submit([this, vertShaderPath]() { return LoadStage(vertShaderPath, 0); }).share() }); // 0表示顶点着色器
+    m_Stages.push_back({ VK_SHADER_STAGE_FRAGMENT_BIT, threadPool.Submit([this, fragShaderPath]() { return LoadStage(fragShaderPath, 1); }).share() }); // 1表示片段着色器
+}
 
-    auto device = VulkanContext::Get()->GetDevice()->GetVulkanDevice();
+VulkanShader::~VulkanShader()
+{
+    auto device = VulkanContext::Get()->GetCurrentDevice();
 
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName = "main";
+    // 编译任务引用了this，必须全部结束后才能析构
+    for (auto& stage : m_Stages)
+    {
+        stage.Result.wait();
+        try
+        {
+            vkDestroyShaderModule(device, stage.Result.get().Module, nullptr);
+        }
+        catch (const std::exception&)
+        {
+            // 编译失败的阶段没有模块需要销毁
+        }
+    }
+    m_Stages.clear();
+    m_PipelineShaderStageCreateInfos.clear();
 
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName = "main";
+    // 描述符布局归设备的布局缓存所有
+}
 
-    m_PipelineShaderStageCreateInfos = {vertShaderStageInfo, fragShaderStageInfo};
+bool VulkanShader::IsReady() const
+{
+    for (const auto& stage : m_Stages)
+    {
+        if (stage.Result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+    }
+    return true;
+}
 
-    CreateDescriptors();
+const std::vector<VkPipelineShaderStageCreateInfo>& VulkanShader::GetPipelineShaderStageCreateInfos() const
+{
+    Resolve();
+    return m_PipelineShaderStageCreateInfos;
 }
 
-VulkanShader::~VulkanShader()
+VkDescriptorSetLayout VulkanShader::GetDescriptorSetLayout(uint32_t set) const
 {
-    auto device = VulkanContext::Get()->GetCurrentDevice();
+    Resolve();
+    return set < m_DescriptorSetLayouts.size() ? m_DescriptorSetLayouts[set] : nullptr;
+}
 
-    for (auto shaderModule : m_PipelineShaderStageCreateInfos)
-        vkDestroyShaderModule(device, shaderModule.module, nullptr);
-    m_PipelineShaderStageCreateInfos.clear();
+const std::vector<VkDescriptorSetLayout>& VulkanShader::GetDescriptorSetLayouts() const
+{
+    Resolve();
+    return m_DescriptorSetLayouts;
+}
+
+const ShaderReflection& VulkanShader::GetReflection() const
+{
+    Resolve();
+    return m_Reflection;
+}
 
-    vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayout, nullptr);
+std::vector<std::filesystem::path> VulkanShader::GetSourceFiles() const
+{
+    std::vector<std::filesystem::path> files = VulkanShaderCache::GetSourceDependencies(m_VertShaderPath);
+    for (auto& file : VulkanShaderCache::GetSourceDependencies(m_FragShaderPath))
+    {
+        if (std::find(files.begin(), files.end(), file) == files.end())
+            files.push_back(file);
+    }
+    return files;
+}
+
+void VulkanShader::Resolve() const
+{
+    std::scoped_lock lock(m_StageMutex);
+    if (m_Resolved)
+        return;
+
+    // 编译错误在这里重新抛出
+    std::vector<VkPipelineShaderStageCreateInfo> stageInfos;
+    ShaderReflection reflection;
+    for (const auto& stage : m_Stages)
+    {
+        const ShaderStageResult& result = stage.Result.get();
+
+        VkPipelineShaderStageCreateInfo stageInfo{};
+        stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stageInfo.stage = stage.Stage;
+        stageInfo.module = result.Module;
+        stageInfo.pName = "main";
+        stageInfos.push_back(stageInfo);
+
+        reflection.Merge(result.Reflection);
+    }
+
+    // 未使用的set编号也需要一个（空）布局，管线布局中的set必须连续
+    // bindless的set使用全局描述符集的布局，反射得到的运行时数组大小没有意义
+    auto device = VulkanContext::Get()->GetDevice();
+    auto& layoutCache = device->GetDescriptorSetLayoutCache();
+    auto* bindless = device->GetBindlessDescriptors();
+    std::vector<VkDescriptorSetLayout> layouts(reflection.GetDescriptorSetCount());
+    for (uint32_t set = 0; set < layouts.size(); set++)
+    {
+        if (bindless && set == VulkanBindlessDescriptors::DescriptorSetIndex)
+            layouts[set] = bindless->GetLayout();
+        else
+            layouts[set] = layoutCache.GetLayout(reflection.GetSetBindings(set));
+    }
+
+    m_PipelineShaderStageCreateInfos = std::move(stageInfos);
+    m_Reflection = std::move(reflection);
+    m_DescriptorSetLayouts = std::move(layouts);
+    m_Resolved = true;
 }
 
 Ref<VulkanShader> VulkanShader::Init()
@@ -61,36 +146,32 @@ VkShaderModule VulkanShader::CreateShaderModule(const std::vector<char>& code)
     return shaderModule;
 }
 
+VkShaderModule VulkanShader::CreateShaderModule(const std::vector<uint32_t>& spirv)
+{
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = spirv.size() * sizeof(uint32_t);
+    createInfo.pCode = spirv.data();
+
+    VkShaderModule shaderModule;
+    auto device = VulkanContext::Get()->GetDevice()->GetVulkanDevice();
+
+    VK_CHECK_RESULT(vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule));
+
+    return shaderModule;
+}
+
 VulkanShader::ShaderDescriptorSet VulkanShader::CreateDescriptorSets()
 {
     ShaderDescriptorSet result;
 
-    VkDevice device = VulkanContext::Get()->GetCurrentDevice();
+    // 每个飞行帧一个set 0的持久描述符集，由调用方通过FreePersistent()释放
+    auto& descriptorSetManager = VulkanContext::Get()->GetDevice()->GetDescriptorSetManager();
     uint32_t framesInFlight = VulkanContext::Get()->GetConfig().FramesInFlight;
 
-    // 创建描述符池
-    std::array<VkDescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = static_cast<uint32_t>(framesInFlight);
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(framesInFlight);
-
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = static_cast<uint32_t>(framesInFlight);
-    VK_CHECK_RESULT(vkCreateDescriptorPool(device, &poolInfo, nullptr, &result.Pool));
-
-    std::vector<VkDescriptorSetLayout> layouts(framesInFlight, m_DescriptorSetLayout);
-    VkDescriptorSetAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = result.Pool;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(framesInFlight);
-    allocInfo.pSetLayouts = layouts.data();
-
     result.DescriptorSets.resize(framesInFlight);
-    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, result.DescriptorSets.data()));
+    for (auto& descriptorSet : result.DescriptorSets)
+        descriptorSet = descriptorSetManager.AllocatePersistent(GetDescriptorSetLayout(0));
 
     return result;
 }
@@ -99,47 +180,55 @@ void VulkanShader::CreateGraphicsPipeline()
 {
 }
 
-void VulkanShader::CreateDescriptors()
+VkShaderModule VulkanShader::ReadShader(const std::string& filepath, int shaderType)
 {
-    auto device = VulkanContext::Get()->GetDevice()->GetVulkanDevice();
-
-    // 创建描述符布局
-    VkDescriptorSetLayoutBinding uboLayoutBinding{};
-    uboLayoutBinding.binding = 0;
-    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uboLayoutBinding.descriptorCount = 1;
-    uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    uboLayoutBinding.pImmutableSamplers = nullptr; // Optional
-
-    VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-    samplerLayoutBinding.binding = 1;
-    samplerLayoutBinding.descriptorCount = 1;
-    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerLayoutBinding.pImmutableSamplers = nullptr;
-    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    return CreateShaderModule(LoadSPIRV(filepath, shaderType));
+}
 
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
-    VkDescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-    layoutInfo.pBindings = bindings.data();
+VulkanShader::ShaderStageResult VulkanShader::LoadStage(const std::string& filepath, int shaderType)
+{
+    std::vector<uint32_t> spvCode = LoadSPIRV(filepath, shaderType);
 
-    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_DescriptorSetLayout))
+    ShaderStageResult result;
+    result.Module = CreateShaderModule(spvCode);
+    result.Reflection = ShaderReflection::Reflect(spvCode, shaderType == 0 ? VK_SHADER_STAGE_VERTEX_BIT : VK_SHADER_STAGE_FRAGMENT_BIT);
+    return result;
 }
 
-VkShaderModule VulkanShader::ReadShader(const std::string& filepath, int shaderType)
+std::vector<uint32_t> VulkanShader::LoadSPIRV(const std::string& filepath, int shaderType)
 {
-    // 编译着色器到SPV格式
-    std::vector<uint32_t> spvCode = CompileToSPV(filepath, shaderType);
-    
-    // 生成SPV文件路径
-    std::filesystem::path shaderPath(filepath);
-    std::string spvFilePath = shaderPath.replace_extension(".spv").string();
-    
-    // 保存SPV到文件
-    SaveSPVToFile(spvCode, spvFilePath);
+    ShaderCompileInfo info;
+    info.Filepath = filepath;
+    switch (shaderType)
+    {
+        case 0: // 顶点着色器
+            info.Stage = shaderc_glsl_vertex_shader;
+            break;
+        case 1: // 片段着色器
+            info.Stage = shaderc_glsl_fragment_shader;
+            break;
+        case 2: // 计算着色器
+            info.Stage = shaderc_glsl_compute_shader;
+            break;
+        default:
+            throw std::runtime_error("Unsupported shader type");
+    }
 
-    return CreateShaderModule(LoadShader(spvFilePath));
+    // 源码、包含文件与编译选项都未变化时直接使用缓存的SPIR-V
+    uint64_t key = VulkanShaderCache::ComputeKey(info);
+    std::vector<uint32_t> spvCode;
+    if (VulkanShaderCache::Load(key, spvCode))
+    {
+        CORE_INFO("Shader '{0}' loaded from cache", filepath);
+    }
+    else
+    {
+        spvCode = CompileToSPV(info);
+        VulkanShaderCache::Store(key, spvCode);
+        CORE_INFO("Shader '{0}' compiled", filepath);
+    }
+
+    return spvCode;
 }
 
 std::vector<char> VulkanShader::LoadShader(const std::string& filepath)
@@ -173,32 +262,26 @@ std::vector<char> VulkanShader::ReadFile(const std::string& filepath)
     return buffer;
 }
 
-std::vector<uint32_t> VulkanShader::CompileToSPV(const std::string& filepath, int shaderType)
+std::vector<uint32_t> VulkanShader::CompileToSPV(const ShaderCompileInfo& info)
 {
     // 使用shaderc库将GLSL代码编译为SPIR-V
-    shaderc::Compiler compiler;
+    // 编译器实例按线程复用，避免每次编译重新创建
+    static thread_local shaderc::Compiler compiler;
     shaderc::CompileOptions options;
+    options.SetIncluder(VulkanShaderCache::CreateIncluder());
+    for (const auto& [name, value] : info.Defines)
+        options.AddMacroDefinition(name, value);
+    if (info.Optimize)
+        options.SetOptimizationLevel(shaderc_optimization_level_performance);
+    if (info.GenerateDebugInfo)
+        options.SetGenerateDebugInfo();
     
     // 读取着色器源码
-    auto shaderSource = ReadFile(filepath);
+    auto shaderSource = ReadFile(info.Filepath);
     std::string source(shaderSource.begin(), shaderSource.end());
     
-    // 确定着色器类型
-    shaderc_shader_kind kind;
-    switch (shaderType) 
-    {
-        case 0: // 顶点着色器
-            kind = shaderc_glsl_vertex_shader;
-            break;
-        case 1: // 片段着色器
-            kind = shaderc_glsl_fragment_shader;
-            break;
-        default:
-            throw std::runtime_error("Unsupported shader type");
-    }
-    
     // 编译着色器
-    shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(source, kind, filepath.c_str());
+    shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(source, info.Stage, info.Filepath.c_str(), options);
     
     if (module.GetCompilationStatus() != shaderc_compilation_status_success) 
     {
@@ -209,19 +292,3 @@ std::vector<uint32_t> VulkanShader::CompileToSPV(const std::string& filepath, in
     // 返回编译后的SPIR-V字节码
     return {module.cbegin(), module.cend()};
 }
-
-void VulkanShader::SaveSPVToFile(const std::vector<uint32_t>& spvData, const std::string& outputPath)
-{
-    // 以二进制模式写入文件
-    std::ofstream file(outputPath, std::ios::binary);
-    
-    if (!file.is_open()) 
-    {
-        throw std::runtime_error("Failed to create output file: " + outputPath);
-    }
-    
-    // 将SPIR-V数据写入文件
-    file.write(reinterpret_cast<const char*>(spvData.data()), spvData.size() * sizeof(uint32_t));
-    
-    file.close();
-}
\ No newline at end of file
@@ -3,12 +3,17 @@
 #include <shaderc/shaderc.hpp>
 #include <vulkan/vulkan.h>
 
+#include "VulkanShaderCache.h"
+#include "ShaderReflection.h"
+
+#include <future>
+#include <mutex>
+
 class VulkanShader
 {
 public:
     struct ShaderDescriptorSet
     {
-        VkDescriptorPool Pool = nullptr;
         std::vector<VkDescriptorSet> DescriptorSets;
     };
 public:
@@ -18,24 +23,60 @@ public:
     static Ref<VulkanShader> Init();
 
     VkShaderModule CreateShaderModule(const std::vector<char>& code);
+    VkShaderModule CreateShaderModule(const std::vector<uint32_t>& spirv);
     ShaderDescriptorSet CreateDescriptorSets();
     void CreateGraphicsPipeline();
-    void CreateDescriptors();
 
-    const std::vector<VkPipelineShaderStageCreateInfo>& GetPipelineShaderStageCreateInfos() const { return m_PipelineShaderStageCreateInfos; }
-    VkDescriptorSetLayout GetDescriptorSetLayout() const { return m_DescriptorSetLayout; }
+    // 所有阶段都已编译完成，此时获取着色器阶段不会阻塞
+    bool IsReady() const;
+    // 以下函数阻塞直到所有阶段编译完成；编译失败时抛出异常
+    const std::vector<VkPipelineShaderStageCreateInfo>& GetPipelineShaderStageCreateInfos() const;
+    // 由反射生成，相同绑定的布局在着色器之间共享；set不存在时返回空
+    VkDescriptorSetLayout GetDescriptorSetLayout(uint32_t set = 0) const;
+    const std::vector<VkDescriptorSetLayout>& GetDescriptorSetLayouts() const;
+    const ShaderReflection& GetReflection() const;
+
+    const std::string& GetVertShaderPath() const { return m_VertShaderPath; }
+    const std::string& GetFragShaderPath() const { return m_FragShaderPath; }
+    // 所有阶段的源文件及其包含的文件，任一变化都需要重新编译
+    std::vector<std::filesystem::path> GetSourceFiles() const;
 
     VkShaderModule ReadShader(const std::string& filepath, int shaderType);
     std::vector<char> LoadShader(const std::string& filepath);
 
+    // 读取缓存或编译单个阶段；shaderType为0（顶点）、1（片段）或2（计算），编译失败时抛出异常
+    static std::vector<uint32_t> LoadSPIRV(const std::string& filepath, int shaderType);
+
 private:
-    std::vector<char> ReadFile(const std::string& filepath);
-    std::vector<uint32_t> CompileToSPV(const std::string& filepath, int shaderType);
-    void SaveSPVToFile(const std::vector<uint32_t>& spvData, const std::string& outputPath);
+    struct ShaderStageResult
+    {
+        VkShaderModule Module = nullptr;
+        ShaderReflection Reflection;
+    };
+
+    // 在工作线程上执行：读取缓存或编译，创建模块并反射
+    ShaderStageResult LoadStage(const std::string& filepath, int shaderType);
+    // 等待所有阶段，合并反射结果并获取描述符布局，只执行一次
+    void Resolve() const;
+
+    static std::vector<char> ReadFile(const std::string& filepath);
+    static std::vector<uint32_t> CompileToSPV(const ShaderCompileInfo& info);
 
 private:
-    std::vector<VkPipelineShaderStageCreateInfo> m_PipelineShaderStageCreateInfos;
+    std::string m_VertShaderPath;
+    std::string m_FragShaderPath;
+
+    struct ShaderStage
+    {
+        VkShaderStageFlagBits Stage;
+        std::shared_future<ShaderStageResult> Result;
+    };
+    std::vector<ShaderStage> m_Stages;
 
-    VkDescriptorSetLayout m_DescriptorSetLayout;
-    VkDescriptorSet m_DescriptorSet;
+    // 由Resolve()填充
+    mutable std::vector<VkPipelineShaderStageCreateInfo> m_PipelineShaderStageCreateInfos;
+    mutable ShaderReflection m_Reflection;
+    mutable std::vector<VkDescriptorSetLayout> m_DescriptorSetLayouts;
+    mutable bool m_Resolved = false;
+    mutable std::mutex m_StageMutex;
 };
\ No newline at end of file
@@ -0,0 +1,243 @@
+#include "pch.h"
+#include "VulkanShaderCache.h"
+
+#include "VulkanContext.h"
+
+#include <thread>
+
+namespace Utils {
+
+	// 缓存格式或编译选项的处理方式变化时递增，使旧条目全部失效
+	static constexpr uint32_t s_ShaderCacheVersion = 1;
+	static constexpr uint32_t s_SpirvMagic = 0x07230203;
+
+	// FNV-1a
+	static void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	static void HashString(uint64_t& hash, const std::string& string)
+	{
+		uint64_t size = string.size();
+		HashBytes(hash, &size, sizeof(size));
+		HashBytes(hash, string.data(), string.size());
+	}
+
+	static bool ReadTextFile(const std::filesystem::path& filepath, std::string& outText)
+	{
+		std::ifstream file(filepath, std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		std::stringstream stream;
+		stream << file.rdbuf();
+		outText = stream.str();
+		return true;
+	}
+
+	// 解析 #include "name" 或 #include <name>，返回name
+	static bool ParseIncludeDirective(const std::string& line, std::string& outName)
+	{
+		size_t pos = line.find_first_not_of(" \t");
+		if (pos == std::string::npos || line[pos] != '#')
+			return false;
+
+		pos = line.find_first_not_of(" \t", pos + 1);
+		if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)
+			return false;
+
+		size_t begin = line.find_first_of("\"<", pos + 7);
+		if (begin == std::string::npos)
+			return false;
+
+		size_t end = line.find_first_of(line[begin] == '"' ? "\"" : ">", begin + 1);
+		if (end == std::string::npos)
+			return false;
+
+		outName = line.substr(begin + 1, end - begin - 1);
+		return true;
+	}
+
+	static void HashSourceRecursive(uint64_t& hash, const std::filesystem::path& filepath, const std::string& source, std::unordered_set<std::string>& visited)
+	{
+		HashString(hash, source);
+
+		std::istringstream stream(source);
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			std::string name;
+			if (!ParseIncludeDirective(line, name))
+				continue;
+
+			std::filesystem::path includePath = VulkanShaderCache::ResolveInclude(filepath, name);
+			HashString(hash, includePath.generic_string());
+
+			// 同一文件只计入一次，也避免循环包含
+			if (!visited.insert(includePath.generic_string()).second)
+				continue;
+
+			// 找不到的文件也计入键（空内容），编译时由shaderc报告错误
+			std::string includeSource;
+			ReadTextFile(includePath, includeSource);
+			HashSourceRecursive(hash, includePath, includeSource, visited);
+		}
+	}
+
+	static std::filesystem::path GetCacheFilepath(uint64_t key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.spv", (unsigned long long)key);
+		return std::filesystem::path(VulkanContext::Get()->GetConfig().ShaderCachePath) / name;
+	}
+
+	class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface
+	{
+	public:
+		shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth) override
+		{
+			auto* include = new IncludeData();
+			include->Path = VulkanShaderCache::ResolveInclude(requestingSource, requestedSource).generic_string();
+			if (ReadTextFile(include->Path, include->Content))
+			{
+				include->Result.source_name = include->Path.c_str();
+				include->Result.source_name_length = include->Path.size();
+			}
+			else
+			{
+				// source_name为空表示包含失败，content为错误信息
+				include->Content = "Failed to open include file: " + include->Path;
+				include->Result.source_name = "";
+				include->Result.source_name_length = 0;
+			}
+			include->Result.content = include->Content.c_str();
+			include->Result.content_length = include->Content.size();
+			include->Result.user_data = include;
+			return &include->Result;
+		}
+
+		void ReleaseInclude(shaderc_include_result* data) override
+		{
+			delete (IncludeData*)data->user_data;
+		}
+	private:
+		struct IncludeData
+		{
+			shaderc_include_result Result{};
+			std::string Path;
+			std::string Content;
+		};
+	};
+
+}
+
+uint64_t VulkanShaderCache::ComputeKey(const ShaderCompileInfo& info)
+{
+	std::string source;
+	if (!Utils::ReadTextFile(info.Filepath, source))
+		throw std::runtime_error("failed to open file: " + info.Filepath);
+
+	uint64_t hash = 14695981039346656037ull;
+	Utils::HashBytes(hash, &Utils::s_ShaderCacheVersion, sizeof(Utils::s_ShaderCacheVersion));
+
+	uint32_t stage = (uint32_t)info.Stage;
+	Utils::HashBytes(hash, &stage, sizeof(stage));
+	Utils::HashBytes(hash, &info.Optimize, sizeof(info.Optimize));
+	Utils::HashBytes(hash, &info.GenerateDebugInfo, sizeof(info.GenerateDebugInfo));
+
+	uint64_t defineCount = info.Defines.size();
+	Utils::HashBytes(hash, &defineCount, sizeof(defineCount));
+	for (const auto& [name, value] : info.Defines)
+	{
+		Utils::HashString(hash, name);
+		Utils::HashString(hash, value);
+	}
+
+	std::unordered_set<std::string> visited;
+	Utils::HashSourceRecursive(hash, info.Filepath, source, visited);
+	return hash;
+}
+
+bool VulkanShaderCache::Load(uint64_t key, std::vector<uint32_t>& outSpirv)
+{
+	std::ifstream file(Utils::GetCacheFilepath(key), std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	size_t fileSize = (size_t)file.tellg();
+	if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0)
+		return false;
+
+	outSpirv.resize(fileSize / sizeof(uint32_t));
+	file.seekg(0);
+	file.read((char*)outSpirv.data(), fileSize);
+
+	// 截断或损坏的条目当作未命中，重新编译后覆盖
+	return file && outSpirv[0] == Utils::s_SpirvMagic;
+}
+
+void VulkanShaderCache::Store(uint64_t key, const std::vector<uint32_t>& spirv)
+{
+	std::filesystem::path filepath = Utils::GetCacheFilepath(key);
+
+	std::error_code error;
+	std::filesystem::create_directories(filepath.parent_path(), error);
+
+	// 先写临时文件再替换，多个线程编译同一着色器时也不会读到写了一半的文件
+	std::filesystem::path tempPath = filepath;
+	tempPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			CORE_WARN("Failed to write shader cache entry '{0}'", tempPath.string());
+			return;
+		}
+		file.write((const char*)spirv.data(), spirv.size() * sizeof(uint32_t));
+	}
+
+	std::filesystem::rename(tempPath, filepath, error);
+	if (error)
+	{
+		CORE_WARN("Failed to write shader cache entry '{0}': {1}", filepath.string(), error.message());
+		std::filesystem::remove(tempPath, error);
+	}
+}
+
+std::vector<std::filesystem::path> VulkanShaderCache::GetSourceDependencies(const std::string& filepath)
+{
+	std::vector<std::filesystem::path> dependencies = { std::filesystem::path(filepath).lexically_normal() };
+
+	std::string source;
+	if (!Utils::ReadTextFile(filepath, source))
+		return dependencies;
+
+	// 与计算缓存键时展开#include的规则相同
+	uint64_t hash = 0;
+	std::unordered_set<std::string> visited;
+	Utils::HashSourceRecursive(hash, filepath, source, visited);
+
+	for (const auto& include : visited)
+		dependencies.push_back(include);
+	return dependencies;
+}
+
+std::unique_ptr<shaderc::CompileOptions::IncluderInterface> VulkanShaderCache::CreateIncluder()
+{
+	return std::make_unique<Utils::ShaderIncluder>();
+}
+
+std::filesystem::path VulkanShaderCache::ResolveInclude(const std::filesystem::path& requestingFile, const std::string& requestedName)
+{
+	std::filesystem::path requested(requestedName);
+	if (requested.is_absolute())
+		return requested.lexically_normal();
+
+	return (requestingFile.parent_path() / requested).lexically_normal();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <shaderc/shaderc.hpp>
+
+// 一次着色器编译的全部输入，决定了缓存键
+struct ShaderCompileInfo
+{
+	std::string Filepath;
+	shaderc_shader_kind Stage = shaderc_glsl_vertex_shader;
+	std::vector<std::pair<std::string, std::string>> Defines;
+	bool Optimize = false;
+	bool GenerateDebugInfo = false;
+};
+
+// 按内容寻址的SPIR-V磁盘缓存
+// 键为源码、所有#include文件内容、宏定义与编译选项的哈希，任一输入变化都会得到新的键，
+// 旧条目不会被覆盖。命中时直接得到SPIR-V，无需调用shaderc
+class VulkanShaderCache
+{
+public:
+	// 读取源码并递归展开#include计算缓存键，源码不存在时抛出异常
+	static uint64_t ComputeKey(const ShaderCompileInfo& info);
+
+	static bool Load(uint64_t key, std::vector<uint32_t>& outSpirv);
+	static void Store(uint64_t key, const std::vector<uint32_t>& spirv);
+
+	// 与ComputeKey使用相同规则解析#include的shaderc包含器
+	static std::unique_ptr<shaderc::CompileOptions::IncluderInterface> CreateIncluder();
+	// 源文件本身及其递归包含的所有文件，源文件无法读取时只返回它自身
+	static std::vector<std::filesystem::path> GetSourceDependencies(const std::string& filepath);
+	// 相对路径先相对于包含它的文件所在目录查找
+	static std::filesystem::path ResolveInclude(const std::filesystem::path& requestingFile, const std::string& requestedName);
+};
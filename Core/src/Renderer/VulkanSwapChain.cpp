@@ -13,7 +13,7 @@ void VulkanSwapChain::Create(uint32_t* width, uint32_t* height)
 	CreateRenderPass();
 	CreateDepthResources();
 	CreateFramebuffers();
-	CreateCommandBuffers();
+	CreateFrameContexts();
 	CreateSyncObjects();
 }
 
@@ -41,15 +41,12 @@ void VulkanSwapChain::Destroy()
 	vkDeviceWaitIdle(device);
 
 	vkDestroyImageView(device, m_DepthImage.ImageView, nullptr);
-	vkDestroyImage(device, m_DepthImage.Image, nullptr);
-	vkFreeMemory(device, m_DepthImage.depthImageMemory, nullptr);
+	m_Device->GetAllocator().DestroyImage(m_DepthImage.Image, m_DepthImage.Allocation);
 
 	for (auto &imageView : m_Images)
 		vkDestroyImageView(m_Device->GetVulkanDevice(), imageView.ImageView, nullptr);
 	m_Images.clear();
-	for (auto& commandBuffer : m_CommandBuffers)
-		vkDestroyCommandPool(device, commandBuffer.CommandPool, nullptr);
-	m_CommandBuffers.clear();
+	m_FrameContexts.clear();
 	for (auto framebuffer : m_Framebuffers)
 		vkDestroyFramebuffer(device, framebuffer, nullptr);
 	m_Framebuffers.clear();
@@ -73,7 +70,10 @@ void VulkanSwapChain::Destroy()
 void VulkanSwapChain::BeginFrame()
 {
 	m_CurrentImageIndex = AcquireNextImage();
-	VK_CHECK_RESULT(vkResetCommandPool(m_Device->GetVulkanDevice(), m_CommandBuffers[m_CurrentFrameIndex].CommandPool, 0));
+
+	// AcquireNextImage已等待该帧的fence，上一轮使用该帧上下文的命令已执行完毕
+	m_FrameContexts[m_CurrentFrameIndex]->Reset();
+	VulkanContext::Get()->GetDevice()->GetDescriptorSetCache().NextFrame();
 }
 
 void VulkanSwapChain::Present()
@@ -89,12 +89,13 @@ void VulkanSwapChain::Present()
 	submitInfo.waitSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores = &m_RenderFinishedSemaphores[m_CurrentFrameIndex];
 	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pCommandBuffers = &m_CommandBuffers[m_CurrentFrameIndex].CommandBuffer;
+	VkCommandBuffer commandBuffer = m_FrameContexts[m_CurrentFrameIndex]->GetCommandBuffer();
+	submitInfo.pCommandBuffers = &commandBuffer;
 	submitInfo.commandBufferCount = 1;
 
 	VK_CHECK_RESULT(vkResetFences(m_Device->GetVulkanDevice(), 1, &m_WaitFences[m_CurrentFrameIndex]));
 
-	VK_CHECK_RESULT(vkQueueSubmit(m_Device->GetGraphicsQueue(), 1, &submitInfo, m_WaitFences[m_CurrentFrameIndex]));
+	VK_CHECK_RESULT(m_Device->QueueSubmit(m_Device->GetGraphicsQueue(), 1, &submitInfo, m_WaitFences[m_CurrentFrameIndex]));
 
 	// 将当前缓冲区呈现给交换链
 	// 传递从提交信息中被命令缓冲提交信号的信号量作为交换链呈现的等待信号量
@@ -110,7 +111,7 @@ void VulkanSwapChain::Present()
 
 		presentInfo.pWaitSemaphores = &m_RenderFinishedSemaphores[m_CurrentFrameIndex];
 		presentInfo.waitSemaphoreCount = 1;
-		result = vkQueuePresentKHR(m_Device->GetGraphicsQueue(), &presentInfo);
+		result = m_Device->QueuePresent(m_Device->GetGraphicsQueue(), presentInfo);
 	}
 
 	if (result != VK_SUCCESS)
@@ -466,31 +467,17 @@ void VulkanSwapChain::CreateFramebuffers()
 	}
 }
 
-void VulkanSwapChain::CreateCommandBuffers()
+void VulkanSwapChain::CreateFrameContexts()
 {
-	auto device = m_Device->GetVulkanDevice();
-
-	for (auto& commandBuffer : m_CommandBuffers)
-		vkDestroyCommandPool(device, commandBuffer.CommandPool, nullptr);
-
-	VkCommandPoolCreateInfo cmdPoolInfo = {};
-	cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-	cmdPoolInfo.queueFamilyIndex = m_QueueNodeIndex;
-
-	VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
-	commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	commandBufferAllocateInfo.commandBufferCount = 1;
-
-	m_CommandBuffers.resize(m_ImageCount);
-	for (auto& commandBuffer : m_CommandBuffers)
-	{
-		VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &commandBuffer.CommandPool));
+	// 帧上下文只与飞行帧数量有关，重建交换链时保留
+	uint32_t framesInFlight = VulkanContext::Get()->GetConfig().FramesInFlight;
+	if (m_FrameContexts.size() == framesInFlight)
+		return;
 
-		commandBufferAllocateInfo.commandPool = commandBuffer.CommandPool;
-		VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &commandBuffer.CommandBuffer));
-	}
+	m_FrameContexts.clear();
+	m_FrameContexts.reserve(framesInFlight);
+	for (uint32_t i = 0; i < framesInFlight; i++)
+		m_FrameContexts.push_back(CreateScope<VulkanFrameContext>(m_Device, m_QueueNodeIndex, i));
 }
 
 void VulkanSwapChain::CreateSyncObjects()
@@ -548,17 +535,7 @@ void VulkanSwapChain::CreateDepthResources()
 	VK_CHECK_RESULT(vkCreateImage(m_Device->GetVulkanDevice(), &imageInfo, nullptr, &m_DepthImage.Image));
 
 	// 分配内存
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(m_Device->GetVulkanDevice(), m_DepthImage.Image, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = m_Device->GetPhysicalDevice()->GetMemoryTypeIndex(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	VK_CHECK_RESULT(vkAllocateMemory(m_Device->GetVulkanDevice(), &allocInfo, nullptr, &m_DepthImage.depthImageMemory));
-
-	vkBindImageMemory(m_Device->GetVulkanDevice(), m_DepthImage.Image, m_DepthImage.depthImageMemory, 0);
+	m_DepthImage.Allocation = m_Device->GetAllocator().AllocateImage(m_DepthImage.Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 	// 创建图像视图
 	VkImageViewCreateInfo viewInfo{};
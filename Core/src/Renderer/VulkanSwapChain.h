@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 
 #include "VulkanDevice.h"
+#include "VulkanFrameContext.h"
 
 struct GLFWwindow;
 
@@ -31,10 +32,15 @@ public:
 	VkFramebuffer GetCurrentFramebuffer() { return GetFramebuffer(m_CurrentImageIndex); }
 	VkFramebuffer GetFramebuffer(uint32_t index) { return m_Framebuffers[index]; }
 	uint32_t GetCurrentImageIndex() { return m_CurrentImageIndex; }
+	uint32_t GetCurrentFrameIndex() { return m_CurrentFrameIndex; }
+
+	// 帧上下文按飞行帧索引，BeginFrame()等待该帧的fence后重置
+	VulkanFrameContext& GetCurrentFrameContext() { return *m_FrameContexts[m_CurrentFrameIndex]; }
+	VulkanFrameContext& GetFrameContext(uint32_t index) { return *m_FrameContexts[index]; }
+	uint32_t GetFrameContextCount() const { return (uint32_t)m_FrameContexts.size(); }
 
 	VkCommandBuffer GetCurrentDrawCommandBuffer() { return GetDrawCommandBuffer(m_CurrentFrameIndex); }
-	VkCommandPool GetCurrentDrawCommandPool() { return m_CommandBuffers[m_CurrentFrameIndex].CommandPool; }
-	VkCommandBuffer GetDrawCommandBuffer(uint32_t index) { return m_CommandBuffers[index].CommandBuffer; }
+	VkCommandBuffer GetDrawCommandBuffer(uint32_t index) { return m_FrameContexts[index]->GetCommandBuffer(); }
 private:
 	uint32_t AcquireNextImage();			// 获取下一个可用的图像索引
 	void FindImageFormatAndColorSpace();	// 找到适合的颜色格式和色彩空间
@@ -45,7 +51,7 @@ private:
 	void CreateImageViews();				// 创建图像视图
 	void CreateRenderPass();				// 创建渲染Pass
 	void CreateFramebuffers();				// 创建帧缓冲区
-	void CreateCommandBuffers();			// 创建命令缓冲区
+	void CreateFrameContexts();				// 创建帧上下文
 	void CreateSyncObjects();				// 创建同步对象
 	void CreateDepthResources();			// 创建深度缓冲区
 private:
@@ -83,7 +89,7 @@ private:
 	struct
 	{
 		VkImage Image = nullptr;
-		VkDeviceMemory depthImageMemory = nullptr;
+		VulkanAllocation Allocation;
 		VkImageView ImageView = nullptr;
 	} m_DepthImage;
 
@@ -93,13 +99,8 @@ private:
 	// Fences to signal that command buffers are ready to be reused (one for each frame in flight)
 	std::vector<VkFence> m_WaitFences;
 
-	// 命令缓冲区
-	struct SwapchainCommandBuffer
-	{
-		VkCommandPool CommandPool = nullptr;
-		VkCommandBuffer CommandBuffer = nullptr;
-	};
-	std::vector<SwapchainCommandBuffer> m_CommandBuffers;
+	// 每个飞行帧一个，持有命令缓冲区、描述符池与uniform区间
+	std::vector<Scope<VulkanFrameContext>> m_FrameContexts;
 	uint32_t m_QueueNodeIndex = UINT32_MAX;
 
 	// 交换链颜色格式和颜色空间
@@ -0,0 +1,186 @@
+#include "pch.h"
+#include "VulkanSyncPool.h"
+
+VulkanSyncPool::VulkanSyncPool(VkDevice device, bool timelineSemaphoreSupported)
+	: m_Device(device), m_TimelineSemaphoreSupported(timelineSemaphoreSupported)
+{
+	// Vulkan 1.0下时间线信号量的函数需要从扩展中加载
+	if (m_TimelineSemaphoreSupported)
+	{
+		m_GetSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValueKHR)vkGetDeviceProcAddr(m_Device, "vkGetSemaphoreCounterValueKHR");
+		m_WaitSemaphores = (PFN_vkWaitSemaphoresKHR)vkGetDeviceProcAddr(m_Device, "vkWaitSemaphoresKHR");
+		m_TimelineSemaphoreSupported = m_GetSemaphoreCounterValue && m_WaitSemaphores;
+	}
+}
+
+VulkanSyncPool::~VulkanSyncPool()
+{
+}
+
+void VulkanSyncPool::Destroy()
+{
+	std::scoped_lock lock(m_Mutex);
+
+	if (m_Stats.FencesLive || m_Stats.SemaphoresLive || m_Stats.TimelineSemaphoresLive)
+		CORE_WARN("VulkanSyncPool: {0} fences, {1} semaphores and {2} timeline semaphores were never released",
+			m_Stats.FencesLive, m_Stats.SemaphoresLive, m_Stats.TimelineSemaphoresLive);
+
+	CORE_INFO("VulkanSyncPool: created {0} fences, {1} semaphores, {2} timeline semaphores",
+		m_Stats.FencesCreated, m_Stats.SemaphoresCreated, m_Stats.TimelineSemaphoresCreated);
+
+	for (auto fence : m_FreeFences)
+		vkDestroyFence(m_Device, fence, nullptr);
+	for (auto semaphore : m_FreeSemaphores)
+		vkDestroySemaphore(m_Device, semaphore, nullptr);
+	for (auto semaphore : m_FreeTimelineSemaphores)
+		vkDestroySemaphore(m_Device, semaphore, nullptr);
+
+	m_FreeFences.clear();
+	m_FreeSemaphores.clear();
+	m_FreeTimelineSemaphores.clear();
+}
+
+VkFence VulkanSyncPool::AcquireFence(bool signaled)
+{
+	std::scoped_lock lock(m_Mutex);
+
+	m_Stats.FencesLive++;
+
+	// 空闲列表中的fence都已重置，需要已触发的fence时只能新建
+	if (!signaled && !m_FreeFences.empty())
+	{
+		VkFence fence = m_FreeFences.back();
+		m_FreeFences.pop_back();
+		return fence;
+	}
+
+	VkFenceCreateInfo fenceCreateInfo{};
+	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceCreateInfo.flags = signaled ? VK_FENCE_CREATE_SIGNALED_BIT : 0;
+
+	VkFence fence;
+	VK_CHECK_RESULT(vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &fence));
+	m_Stats.FencesCreated++;
+	return fence;
+}
+
+void VulkanSyncPool::ReleaseFence(VkFence fence)
+{
+	if (!fence)
+		return;
+
+	VK_CHECK_RESULT(vkResetFences(m_Device, 1, &fence));
+
+	std::scoped_lock lock(m_Mutex);
+	m_FreeFences.push_back(fence);
+	m_Stats.FencesLive--;
+}
+
+VkSemaphore VulkanSyncPool::AcquireSemaphore()
+{
+	std::scoped_lock lock(m_Mutex);
+
+	m_Stats.SemaphoresLive++;
+
+	if (!m_FreeSemaphores.empty())
+	{
+		VkSemaphore semaphore = m_FreeSemaphores.back();
+		m_FreeSemaphores.pop_back();
+		return semaphore;
+	}
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo{};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VkSemaphore semaphore;
+	VK_CHECK_RESULT(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &semaphore));
+	m_Stats.SemaphoresCreated++;
+	return semaphore;
+}
+
+void VulkanSyncPool::ReleaseSemaphore(VkSemaphore semaphore)
+{
+	if (!semaphore)
+		return;
+
+	// 二值信号量在等待操作完成后自动回到未触发状态，不需要额外重置
+	std::scoped_lock lock(m_Mutex);
+	m_FreeSemaphores.push_back(semaphore);
+	m_Stats.SemaphoresLive--;
+}
+
+VkSemaphore VulkanSyncPool::AcquireTimelineSemaphore(uint64_t& outValue)
+{
+	CORE_ASSERT(m_TimelineSemaphoreSupported, "Timeline semaphores are not supported on this device!");
+
+	VkSemaphore semaphore = nullptr;
+	{
+		std::scoped_lock lock(m_Mutex);
+
+		m_Stats.TimelineSemaphoresLive++;
+
+		if (!m_FreeTimelineSemaphores.empty())
+		{
+			semaphore = m_FreeTimelineSemaphores.back();
+			m_FreeTimelineSemaphores.pop_back();
+		}
+	}
+
+	if (semaphore)
+	{
+		outValue = GetTimelineSemaphoreValue(semaphore);
+		return semaphore;
+	}
+
+	VkSemaphoreTypeCreateInfoKHR typeCreateInfo{};
+	typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+	typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+	typeCreateInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo{};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreCreateInfo.pNext = &typeCreateInfo;
+	VK_CHECK_RESULT(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &semaphore));
+
+	{
+		std::scoped_lock lock(m_Mutex);
+		m_Stats.TimelineSemaphoresCreated++;
+	}
+
+	outValue = 0;
+	return semaphore;
+}
+
+void VulkanSyncPool::ReleaseTimelineSemaphore(VkSemaphore semaphore)
+{
+	if (!semaphore)
+		return;
+
+	// 计数值不能回退，下次借出时从当前值继续
+	std::scoped_lock lock(m_Mutex);
+	m_FreeTimelineSemaphores.push_back(semaphore);
+	m_Stats.TimelineSemaphoresLive--;
+}
+
+uint64_t VulkanSyncPool::GetTimelineSemaphoreValue(VkSemaphore semaphore) const
+{
+	uint64_t value = 0;
+	VK_CHECK_RESULT(m_GetSemaphoreCounterValue(m_Device, semaphore, &value));
+	return value;
+}
+
+void VulkanSyncPool::WaitTimelineSemaphore(VkSemaphore semaphore, uint64_t value, uint64_t timeout) const
+{
+	VkSemaphoreWaitInfoKHR waitInfo{};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &semaphore;
+	waitInfo.pValues = &value;
+	VK_CHECK_RESULT(m_WaitSemaphores(m_Device, &waitInfo, timeout));
+}
+
+VulkanSyncPoolStats VulkanSyncPool::GetStats() const
+{
+	std::scoped_lock lock(m_Mutex);
+	return m_Stats;
+}
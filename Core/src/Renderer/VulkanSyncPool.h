@@ -0,0 +1,58 @@
+#pragma once
+#include "Vulkan.h"
+
+#include <mutex>
+
+struct VulkanSyncPoolStats
+{
+	// Created为累计创建次数，Live为当前借出未归还的数量
+	uint32_t FencesCreated = 0;
+	uint32_t FencesLive = 0;
+	uint32_t SemaphoresCreated = 0;
+	uint32_t SemaphoresLive = 0;
+	uint32_t TimelineSemaphoresCreated = 0;
+	uint32_t TimelineSemaphoresLive = 0;
+};
+
+// 同步对象回收池
+// fence、二值信号量与时间线信号量归还后放回空闲列表，下次借出时直接复用，避免反复创建销毁
+class VulkanSyncPool
+{
+public:
+	VulkanSyncPool(VkDevice device, bool timelineSemaphoreSupported);
+	~VulkanSyncPool();
+
+	void Destroy();
+
+	// 借出的fence处于未触发状态；signaled为true时创建已触发的fence（用于每帧等待的fence）
+	VkFence AcquireFence(bool signaled = false);
+	// 归还时fence会被重置，归还前它必须已触发或从未提交
+	void ReleaseFence(VkFence fence);
+
+	VkSemaphore AcquireSemaphore();
+	// 归还前信号量不能有未完成的信号或等待操作
+	void ReleaseSemaphore(VkSemaphore semaphore);
+
+	// 需要VK_KHR_timeline_semaphore
+	bool IsTimelineSemaphoreSupported() const { return m_TimelineSemaphoreSupported; }
+	// 时间线信号量无法重置，outValue为当前计数值，之后的信号值必须大于它
+	VkSemaphore AcquireTimelineSemaphore(uint64_t& outValue);
+	void ReleaseTimelineSemaphore(VkSemaphore semaphore);
+	uint64_t GetTimelineSemaphoreValue(VkSemaphore semaphore) const;
+	void WaitTimelineSemaphore(VkSemaphore semaphore, uint64_t value, uint64_t timeout = UINT64_MAX) const;
+
+	VulkanSyncPoolStats GetStats() const;
+private:
+	VkDevice m_Device = nullptr;
+	bool m_TimelineSemaphoreSupported = false;
+
+	PFN_vkGetSemaphoreCounterValueKHR m_GetSemaphoreCounterValue = nullptr;
+	PFN_vkWaitSemaphoresKHR m_WaitSemaphores = nullptr;
+
+	std::vector<VkFence> m_FreeFences;
+	std::vector<VkSemaphore> m_FreeSemaphores;
+	std::vector<VkSemaphore> m_FreeTimelineSemaphores;
+
+	VulkanSyncPoolStats m_Stats;
+	mutable std::mutex m_Mutex;
+};
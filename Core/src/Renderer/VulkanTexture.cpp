@@ -9,6 +9,8 @@
 
 #include <glm\gtc\integer.hpp>
 
+#include <optional>
+
 namespace Utils {
     static bool ValidateSpecification(const TextureSpecification& specification)
     {
@@ -19,153 +21,393 @@ namespace Utils {
 
         return result;
     }
+
+    static void InsertImageBarrier(VkCommandBuffer commandBuffer, VkImage image, uint32_t levelCount,
+        VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
+        VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.image = image;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = levelCount;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcAccessMask = srcAccessMask;
+        barrier.dstAccessMask = dstAccessMask;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            srcStageMask, dstStageMask, 0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+    }
+}
+
+VulkanTexture::VulkanTexture(const TextureSpecification& specification, const std::filesystem::path& filepath, VulkanUploadBatch* batch)
+    : VulkanTexture(*LoadData(specification, filepath), batch)
+{
+}
+
+VulkanTexture::VulkanTexture(TextureData& data, VulkanUploadBatch* batch)
+    : m_Specification(data.Specification), m_Path(data.Filepath), m_Format(data.Format)
+{
+    Utils::ValidateSpecification(m_Specification);
+
+    bool useBaked = data.Baked;
+
+    // 流式纹理保留烘焙数据，先只上传mip尾部，高级别由TextureStreamer按需调入
+    m_Streaming = useBaked && m_Specification.Streaming;
+    if (m_Streaming)
+    {
+        m_StreamSource = std::move(data.BakedData);
+        m_MipTailLevel = GetMipLevelForSize(VulkanContext::Get()->GetConfig().TextureStreamingMipTailSize);
+        m_ResidentMip = m_MipTailLevel;
+    }
+    const BakedTexture& baked = m_Streaming ? m_StreamSource : data.BakedData;
+
+    // 计算着色器生成mip时图像以UNORM存储格式创建，采样视图仍使用sRGB格式
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    VkImageCreateFlags flags = 0;
+    m_ComputeMips = !useBaked && VulkanContext::Get()->GetConfig().ComputeMipGeneration && GetMipLevelCount() > 1 && VulkanMipGenerator::IsFormatSupported(m_Format);
+    if (m_ComputeMips)
+    {
+        usage = VulkanMipGenerator::GetImageUsage();
+        flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+    }
+
+    CreateImage(usage, flags);
+
+    if (m_ComputeMips)
+        CreateMipStorageViews();
+
+    // 拷贝、生成mip与布局转换都记录进同一个上传批次，不再逐步提交等待
+    std::optional<VulkanUploadBatch> localBatch;
+    if (!batch)
+        batch = &localBatch.emplace();
+
+    if (useBaked)
+    {
+        // 从文件映射直接拷贝进暂存环，非流式纹理之后不再需要CPU端的数据
+        UploadBakedLevels(*batch, baked, m_ResidentMip, GetMipLevelCount());
+        if (!m_Streaming)
+            data.BakedData.Release();
+
+        // 所有级别都已写入，直接转换为着色器只读
+        Utils::InsertImageBarrier(batch->GetCommandBuffer(), m_Image, GetResidentLevelCount(),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+    else
+    {
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = {
+            m_Specification.Width,
+            m_Specification.Height,
+            1
+        };
+
+        VkImageSubresourceRange subresourceRange{};
+        subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        subresourceRange.baseMipLevel = 0;
+        subresourceRange.levelCount = GetMipLevelCount();
+        subresourceRange.baseArrayLayer = 0;
+        subresourceRange.layerCount = 1;
+
+        batch->UploadImage(m_Image, data.Pixels.Data, data.Pixels.Size, { region }, subresourceRange);
+        data.Pixels.Release();
+        GenerateMips(batch->GetCommandBuffer());
+    }
+
+    if (localBatch)
+        localBatch->Submit();
+
+    CreateTextureImageView();
+    CreateTextureSampler();
 }
 
-VulkanTexture::VulkanTexture(const TextureSpecification& specification, const std::filesystem::path& filepath)
-    : m_Specification(specification), m_Path(filepath)
+VulkanTexture::~VulkanTexture()
 {
     auto vkDevice = VulkanContext::Get()->GetDevice();
     auto device = vkDevice->GetVulkanDevice();
-    VkCommandBuffer commandBuffer = vkDevice->GetCommandBuffer(true);
-    auto physicalDevice = VulkanContext::Get()->GetPhysicalDevice();
 
-    Utils::ValidateSpecification(specification);
+    // 句柄可能被之后创建的视图复用，先移除引用它的缓存集合
+    vkDevice->GetDescriptorSetCache().Invalidate(m_ImageView);
+    for (VkImageView view : m_MipStorageViews)
+        vkDevice->GetDescriptorSetCache().Invalidate(view);
+
+    vkDestroySampler(device, m_Sampler, nullptr);
+    vkDestroyImageView(device, m_ImageView, nullptr);
+    for (VkImageView view : m_MipStorageViews)
+        vkDestroyImageView(device, view, nullptr);
+
+    vkDevice->GetAllocator().DestroyImage(m_Image, m_ImageAllocation);
+}
+
+Ref<VulkanTexture> VulkanTexture::Create(const TextureSpecification& specification, const std::filesystem::path& filepath, VulkanUploadBatch* batch)
+{
+	return CreateRef<VulkanTexture>(specification, filepath, batch);
+}
+
+Ref<VulkanTexture> VulkanTexture::Create(TextureData& data, VulkanUploadBatch* batch)
+{
+	return CreateRef<VulkanTexture>(data, batch);
+}
+
+Scope<TextureData> VulkanTexture::LoadData(const TextureSpecification& specification, const std::filesystem::path& filepath)
+{
+    Scope<TextureData> data = CreateScope<TextureData>();
+    data->Specification = specification;
+    data->Filepath = filepath;
+
+    // 优先使用烘焙好的纹理：mip已预先生成，压缩块直接上传
+    TextureBakeInfo bakeInfo;
+    bakeInfo.Filepath = filepath.string();
+    bakeInfo.NormalMap = specification.NormalMap;
+
+    data->Baked = VulkanContext::Get()->GetConfig().TextureCache && VulkanTextureCache::Load(bakeInfo, data->BakedData);
+    if (data->Baked)
+    {
+        data->Specification.Width = data->BakedData.Width;
+        data->Specification.Height = data->BakedData.Height;
+        data->Format = data->BakedData.Format;
+        return data;
+    }
 
     // stb_image处理图像数据
-    m_ImageData = ToBufferFromFile(filepath, m_Specification.Width, m_Specification.Height);
+    data->Pixels = ToBufferFromFile(filepath, data->Specification.Width, data->Specification.Height);
+    if (!data->Pixels.Data)
+        throw std::runtime_error("failed to load texture image: " + filepath.string());
 
-    // 在设备上创建最优分块目标图像
-    VkImageCreateInfo imageInfo{};
-    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.extent = { m_Specification.Width, m_Specification.Height, 1 };
-    imageInfo.extent.depth = 1;
-    imageInfo.arrayLayers = 1;
-    imageInfo.mipLevels = GetMipLevelCount();
-    // TODO: 这里应该根据具体的格式选择合适的格式
-    imageInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
-    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-    imageInfo.flags = 0; // Optional
+    data->Format = specification.NormalMap ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
+    return data;
+}
+
+void VulkanTexture::SetResidentMipLevel(uint32_t mipLevel, VulkanUploadBatch& batch)
+{
+    CORE_ASSERT(m_Streaming && mipLevel <= m_MipTailLevel);
+    if (mipLevel == m_ResidentMip)
+        return;
+
+    auto vkDevice = VulkanContext::Get()->GetDevice();
 
-    VK_CHECK_RESULT(vkCreateImage(device, &imageInfo, nullptr, &m_Image));
+    VkImage oldImage = m_Image;
+    VkImageView oldImageView = m_ImageView;
+    VulkanAllocation oldAllocation = m_ImageAllocation;
+    uint32_t oldResidentMip = m_ResidentMip;
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingMemory;
+    // 图像大小随常驻级别变化，只能重新创建，两边都有的级别在GPU上拷贝
+    m_ResidentMip = mipLevel;
+    CreateImage(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0);
+    CreateTextureImageView();
 
-    VulkanBuffer buffer;
-    buffer.CreateBuffer(m_ImageData.Size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingMemory);
-    buffer.Allocate(m_ImageData.Data, m_ImageData.Size, stagingMemory);
+    // 调入时新增的级别从烘焙数据上传，上传会把新图像转换为TRANSFER_DST
+    if (mipLevel < oldResidentMip)
+        UploadBakedLevels(batch, m_StreamSource, mipLevel, oldResidentMip);
 
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(device, m_Image, &memRequirements);
+    // 暂存空间不足时上传会先提交批次中已记录的部分，之后的命令必须记录进上传之后的命令缓冲区
+    VkCommandBuffer commandBuffer = batch.GetCommandBuffer();
 
-    physicalDevice->GetMemoryProperties();
+    // 驱逐时只需转换布局
+    if (mipLevel > oldResidentMip)
+    {
+        Utils::InsertImageBarrier(commandBuffer, m_Image, GetResidentLevelCount(),
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            0, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    }
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = physicalDevice->GetMemoryTypeIndex(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    // 之前提交的帧仍在采样旧图像，屏障等它们读完再转换
+    Utils::InsertImageBarrier(commandBuffer, oldImage, GetMipLevelCount() - oldResidentMip,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-    VK_CHECK_RESULT(vkAllocateMemory(device, &allocInfo, nullptr, &m_DeviceMemory));
+    std::vector<VkImageCopy> copies;
+    for (uint32_t level = std::max(mipLevel, oldResidentMip); level < GetMipLevelCount(); level++)
+    {
+        VkImageCopy copy{};
+        copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - oldResidentMip, 0, 1 };
+        copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - mipLevel, 0, 1 };
+        copy.extent = { GetMipWidth(level), GetMipHeight(level), 1 };
+        copies.push_back(copy);
+    }
+    vkCmdCopyImage(commandBuffer, oldImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)copies.size(), copies.data());
 
-    vkBindImageMemory(device, m_Image, m_DeviceMemory, 0);
+    Utils::InsertImageBarrier(commandBuffer, m_Image, GetResidentLevelCount(),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
 
-    TransitionImageLayout(m_Image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    // 跟随记录了拷贝的那次提交释放：它的fence同时覆盖图形队列上之前提交的、仍在采样旧图像的帧，
+    // 批次中途提交或等待传输队列时也不会提前释放
+    batch.DeferUntilComplete([vkDevice, oldImage, oldImageView, oldAllocation]() mutable
+    {
+        vkDevice->GetDescriptorSetCache().Invalidate(oldImageView);
+        vkDestroyImageView(vkDevice->GetVulkanDevice(), oldImageView, nullptr);
+        vkDevice->GetAllocator().DestroyImage(oldImage, oldAllocation);
+    });
+}
 
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = { 0, 0, 0 };
-    region.imageExtent = {
-        m_Specification.Width,
-        m_Specification.Height,
-        1
-    };
+uint32_t VulkanTexture::GetMipLevelForSize(uint32_t size) const
+{
+    // 较长边不小于size的最小级别
+    uint32_t level = 0;
+    while (level + 1 < GetMipLevelCount() && std::max(GetMipWidth(level + 1), GetMipHeight(level + 1)) >= size)
+        level++;
+    return level;
+}
 
-    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+uint64_t VulkanTexture::GetStreamingSize(uint32_t mipLevel) const
+{
+    uint64_t size = 0;
+    for (uint32_t level = mipLevel; level < (uint32_t)m_StreamSource.Levels.size(); level++)
+        size += m_StreamSource.Levels[level].Size;
+    return size;
+}
 
-    vkDevice->FlushCommandBuffer(commandBuffer);
+void VulkanTexture::CreateImage(VkImageUsageFlags usage, VkImageCreateFlags flags)
+{
+    auto vkDevice = VulkanContext::Get()->GetDevice();
 
-    TransitionImageLayout(m_Image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // 在设备上创建最优分块目标图像，流式纹理只包含常驻的级别
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = { GetMipWidth(m_ResidentMip), GetMipHeight(m_ResidentMip), 1 };
+    imageInfo.arrayLayers = 1;
+    imageInfo.mipLevels = GetResidentLevelCount();
+    imageInfo.format = m_ComputeMips ? VulkanMipGenerator::GetStorageFormat(m_Format) : m_Format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.flags = flags;
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingMemory, nullptr);
+    VK_CHECK_RESULT(vkCreateImage(vkDevice->GetVulkanDevice(), &imageInfo, nullptr, &m_Image));
 
-    CreateTextureImageView();
-    CreateTextureSampler();
-    GenerateMips();
+    // 从设备分配器中子分配图像内存并绑定
+    m_ImageAllocation = vkDevice->GetAllocator().AllocateImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 }
 
-VulkanTexture::~VulkanTexture()
+void VulkanTexture::UploadBakedLevels(VulkanUploadBatch& batch, const BakedTexture& baked, uint32_t firstLevel, uint32_t endLevel)
 {
-    auto device = VulkanContext::Get()->GetCurrentDevice();
+    // 级别在烘焙数据中连续存放，[firstLevel, endLevel)作为一段上传，每个级别一个拷贝区域
+    uint64_t dataOffset = baked.Levels[firstLevel].Offset;
+    uint64_t dataSize = baked.Levels[endLevel - 1].Offset + baked.Levels[endLevel - 1].Size - dataOffset;
 
-    vkDestroyImage(device, m_Image, nullptr);
-    vkFreeMemory(device, m_DeviceMemory, nullptr);
+    std::vector<VkBufferImageCopy> regions;
+    for (uint32_t level = firstLevel; level < endLevel; level++)
+    {
+        VkBufferImageCopy region{};
+        region.bufferOffset = baked.Levels[level].Offset - dataOffset;
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - m_ResidentMip, 0, 1 };
+        region.imageExtent = { baked.Levels[level].Width, baked.Levels[level].Height, 1 };
+        regions.push_back(region);
+    }
 
-    vkDestroySampler(device, m_Sampler, nullptr);
-    vkDestroyImageView(device, m_ImageView, nullptr);
+    VkImageSubresourceRange subresourceRange{};
+    subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    subresourceRange.baseMipLevel = 0;
+    subresourceRange.levelCount = GetResidentLevelCount();
+    subresourceRange.baseArrayLayer = 0;
+    subresourceRange.layerCount = 1;
+
+    batch.UploadImage(m_Image, baked.Data + dataOffset, dataSize, regions, subresourceRange);
 }
 
-Ref<VulkanTexture> VulkanTexture::Create(const TextureSpecification& specification, const std::filesystem::path& filepath)
+void VulkanTexture::GenerateMips(VkCommandBuffer commandBuffer)
 {
-	return CreateRef<VulkanTexture>(specification, filepath);
+    // 调用前所有 mip 级别处于 TRANSFER_DST_OPTIMAL 且 level 0 已写入，完成后全部处于 SHADER_READ_ONLY_OPTIMAL
+    if (m_ComputeMips)
+        GenerateMipsCompute(commandBuffer);
+    else
+        GenerateMipsBlit(commandBuffer);
 }
 
-void VulkanTexture::GenerateMips()
+void VulkanTexture::GenerateMipsCompute(VkCommandBuffer commandBuffer)
 {
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = m_Image;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = GetMipLevelCount();
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
 
-    VkImageSubresourceRange subresourceRange = {};
-    subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    subresourceRange.levelCount = 1;
-    subresourceRange.layerCount = 1;
-    barrier.subresourceRange = subresourceRange;
+    // 所有级别转换为 GENERAL，level 0 的拷贝结果对计算着色器可见
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
 
-    int32_t mipWidth = m_Specification.Width;
-    int32_t mipHeight = m_Specification.Height;
+    vkCmdPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        0, nullptr,
+        0, nullptr,
+        1, &barrier);
 
-    VkCommandBuffer commandBuffer = VulkanContext::Get()->GetDevice()->GetCommandBuffer(true);
+    VulkanContext::Get()->GetDevice()->GetMipGenerator().Generate(commandBuffer, m_Image, m_Format, m_Specification.Width, m_Specification.Height, m_MipStorageViews);
 
-    // 先将基础 mip 级别 (level 0) 从 SHADER_READ_ONLY 转换为 TRANSFER_SRC 布局
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
     vkCmdPipelineBarrier(commandBuffer,
-        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
         0, nullptr,
         0, nullptr,
         1, &barrier);
+}
+
+void VulkanTexture::GenerateMipsBlit(VkCommandBuffer commandBuffer)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.image = m_Image;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+    VkImageSubresourceRange subresourceRange = {};
+    subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    subresourceRange.levelCount = 1;
+    subresourceRange.layerCount = 1;
+    barrier.subresourceRange = subresourceRange;
+
+    int32_t mipWidth = m_Specification.Width;
+    int32_t mipHeight = m_Specification.Height;
 
     auto mipLevels = GetMipLevelCount();
     for (uint32_t i = 1; i < mipLevels; i++)
     {
-        // 首先确保目标 mip 级别处于正确的布局
-        barrier.subresourceRange.baseMipLevel = i;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        // 上一级从 TRANSFER_DST 转换为 TRANSFER_SRC 作为 blit 的源
+        barrier.subresourceRange.baseMipLevel = i - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
         vkCmdPipelineBarrier(commandBuffer,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
             0, nullptr,
             0, nullptr,
             1, &barrier);
@@ -191,14 +433,14 @@ void VulkanTexture::GenerateMips()
             1, &blit,
             VK_FILTER_LINEAR);
 
-        // 将刚刚写入的 mip 级别转换为 TRANSFER_SRC_OPTIMAL 布局，为下一次迭代做准备
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        // 上一级不再被使用，转换为着色器只读
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
         vkCmdPipelineBarrier(commandBuffer,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
             0, nullptr,
             0, nullptr,
             1, &barrier);
@@ -209,12 +451,11 @@ void VulkanTexture::GenerateMips()
             mipHeight /= 2;
     }
 
-    // Transition all mips from transfer to shader read
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = mipLevels;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    // 最后一级只被写入过，直接从 TRANSFER_DST 转换为着色器只读
+    barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
     vkCmdPipelineBarrier(commandBuffer,
@@ -222,8 +463,6 @@ void VulkanTexture::GenerateMips()
         0, nullptr,
         0, nullptr,
         1, &barrier);
-
-    VulkanContext::Get()->GetDevice()->FlushCommandBuffer(commandBuffer);
 }
 
 uint32_t VulkanTexture::GetMipLevelCount() const
@@ -239,16 +478,45 @@ void VulkanTexture::CreateTextureImageView()
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = m_Image;
     viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+    viewInfo.format = m_Format;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = GetResidentLevelCount();
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
+    // 图像以UNORM存储格式创建时，sRGB视图不能继承图像的STORAGE用途
+    VkImageViewUsageCreateInfoKHR usageInfo{};
+    usageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO_KHR;
+    usageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (m_ComputeMips && VulkanMipGenerator::GetStorageFormat(m_Format) != m_Format)
+        viewInfo.pNext = &usageInfo;
+
     VK_CHECK_RESULT(vkCreateImageView(device, &viewInfo, nullptr, &m_ImageView));
 }
 
+void VulkanTexture::CreateMipStorageViews()
+{
+    auto device = VulkanContext::Get()->GetCurrentDevice();
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = m_Image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VulkanMipGenerator::GetStorageFormat(m_Format);
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    m_MipStorageViews.resize(GetMipLevelCount());
+    for (uint32_t i = 0; i < GetMipLevelCount(); i++)
+    {
+        viewInfo.subresourceRange.baseMipLevel = i;
+        VK_CHECK_RESULT(vkCreateImageView(device, &viewInfo, nullptr, &m_MipStorageViews[i]));
+    }
+}
+
 void VulkanTexture::CreateTextureSampler()
 {
     auto device = VulkanContext::Get()->GetCurrentDevice();
@@ -269,63 +537,11 @@ void VulkanTexture::CreateTextureSampler()
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     samplerInfo.mipLodBias = 0.0f;
     samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = 0.0f;
+    samplerInfo.maxLod = static_cast<float>(GetMipLevelCount());
 
     VK_CHECK_RESULT(vkCreateSampler(device, &samplerInfo, nullptr, &m_Sampler));
 }
 
-void VulkanTexture::TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) 
-{
-    auto device = VulkanContext::Get()->GetDevice();
-
-    VkCommandBuffer commandBuffer = device->GetCommandBuffer(true);
-
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
-    else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    }
-    else {
-        throw std::invalid_argument("unsupported layout transition!");
-    }
-
-    vkCmdPipelineBarrier(
-        commandBuffer,
-        sourceStage, destinationStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier
-    );
-
-    device->FlushCommandBuffer(commandBuffer);
-}
-
 Buffer VulkanTexture::ToBufferFromFile(const std::filesystem::path& path, uint32_t& outWidth, uint32_t& outHeight)
 {
     std::string pathString = path.string();
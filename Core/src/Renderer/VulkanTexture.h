@@ -2,6 +2,7 @@
 #include "Vulkan.h"
 
 #include "Buffer/Buffer.h"
+#include "VulkanTextureCache.h"
 
 #include <filesystem>
 
@@ -10,39 +11,99 @@ struct TextureSpecification
 	// TODO:Ӧڴ˴Ƿmipmapѡ
 	uint32_t Width = 1;
 	uint32_t Height = 1;
+	// ͼݴ決ʱѹΪBC5
+	bool NormalMap = false;
+	// ʽأֻϴmipβ߼TextureStreamer룻ֻԺ決õЧפ
+	bool Streaming = false;
+};
+
+// CPUݣ決õѹ𣬻stb_imageRGBA
+// ׼ʱֻļ棬ڹ߳ɣٽȾ̴߳ͼϴ
+struct TextureData
+{
+	TextureSpecification Specification;
+	std::filesystem::path Filepath;
+	VkFormat Format = VK_FORMAT_UNDEFINED;
+
+	bool Baked = false;
+	BakedTexture BakedData;
+	Buffer Pixels;
+
+	TextureData() = default;
+	~TextureData() { Pixels.Release(); }
+
+	TextureData(const TextureData&) = delete;
+	TextureData& operator=(const TextureData&) = delete;
 };
 
 // TODO: Move vkImage to VulkanImage2D
 class VulkanTexture
 {
 public:
-	VulkanTexture(const TextureSpecification& specification, const std::filesystem::path& filepath);
+	VulkanTexture(const TextureSpecification& specification, const std::filesystem::path& filepath, VulkanUploadBatch* batch = nullptr);
+	// ϴ¼κͷdataеCPU
+	VulkanTexture(TextureData& data, VulkanUploadBatch* batch = nullptr);
 	~VulkanTexture();
 
-	static Ref<VulkanTexture> Create(const TextureSpecification& specification, const std::filesystem::path& filepath);
+	static Ref<VulkanTexture> Create(const TextureSpecification& specification, const std::filesystem::path& filepath, VulkanUploadBatch* batch = nullptr);
+	static Ref<VulkanTexture> Create(TextureData& data, VulkanUploadBatch* batch = nullptr);
+
+	// ȡͼļVulkan󣬿̵߳ãʧʱ׳쳣
+	static Scope<TextureData> LoadData(const TextureSpecification& specification, const std::filesystem::path& filepath);
 
-	void GenerateMips();
 	uint32_t GetMipLevelCount() const;
 
 	VkImage GetImage() const { return m_Image; }
 	VkImageView GetImageView() const { return m_ImageView; }
 	VkSampler GetSampler() const { return m_Sampler; }
+
+	bool IsStreaming() const { return m_Streaming; }
+	// mipеǰפ߼ͼĵ0Ӧ
+	uint32_t GetResidentMipLevel() const { return m_ResidentMip; }
+	// ʼճפmipβʼ
+	uint32_t GetMipTailLevel() const { return m_MipTailLevel; }
+	// ϳ߲СsizeС
+	uint32_t GetMipLevelForSize(uint32_t size) const;
+	// mipLevelĩĺ決ڹʽԴռ
+	uint64_t GetStreamingSize(uint32_t mipLevel) const;
+	// ´ֻ[mipLevel, ĩ]ͼ񣬿ϴ¼batchͼͼڼ¼Ǵύɺ
+	// Ⱦ߳ϵã֮GetImageView()µͼ
+	void SetResidentMipLevel(uint32_t mipLevel, VulkanUploadBatch& batch);
 private:
+	void CreateImage(VkImageUsageFlags usage, VkImageCreateFlags flags);
+	// ϴmip[firstLevel, endLevel)ͼмתΪTRANSFER_DST
+	void UploadBakedLevels(VulkanUploadBatch& batch, const BakedTexture& baked, uint32_t firstLevel, uint32_t endLevel);
+	uint32_t GetResidentLevelCount() const { return GetMipLevelCount() - m_ResidentMip; }
+	uint32_t GetMipWidth(uint32_t level) const { return std::max(m_Specification.Width >> level, 1u); }
+	uint32_t GetMipHeight(uint32_t level) const { return std::max(m_Specification.Height >> level, 1u); }
+
 	void CreateTextureImageView();
 	void CreateTextureSampler();
-	void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-	Buffer ToBufferFromFile(const std::filesystem::path& path, uint32_t& outWidth, uint32_t& outHeight);
+	void GenerateMips(VkCommandBuffer commandBuffer);
+	void GenerateMipsBlit(VkCommandBuffer commandBuffer);
+	void GenerateMipsCompute(VkCommandBuffer commandBuffer);
+	void CreateMipStorageViews();
+	static Buffer ToBufferFromFile(const std::filesystem::path& path, uint32_t& outWidth, uint32_t& outHeight);
 private:
 	TextureSpecification m_Specification;
 	std::filesystem::path m_Path;
-
-	Buffer m_ImageData;
 	
 	VkImage m_Image;
 	VkImageView m_ImageView;
 	VkSampler m_Sampler;
 
+	// ɫmipʱÿĴ洢ͼ
+	bool m_ComputeMips = false;
+	VkFormat m_Format = VK_FORMAT_R8G8B8A8_SRGB;
+	std::vector<VkImageView> m_MipStorageViews;
+
+	// ʽ決ݣͼֻ[m_ResidentMip, ĩ]
+	bool m_Streaming = false;
+	uint32_t m_ResidentMip = 0;
+	uint32_t m_MipTailLevel = 0;
+	BakedTexture m_StreamSource;
+
 	VkDeviceSize m_Size;
-	VkDeviceMemory m_DeviceMemory;
+	VulkanAllocation m_ImageAllocation;
 };
 
@@ -0,0 +1,335 @@
+#include "pch.h"
+#include "VulkanTextureCache.h"
+
+#include "VulkanContext.h"
+#include "TextureCompressor.h"
+
+#include <stb_image.h>
+
+#include <thread>
+
+namespace Utils {
+
+	// 缓存格式、mip滤波或压缩器变化时递增，使旧条目全部失效
+	static constexpr uint32_t s_TextureCacheVersion = 1;
+	static constexpr uint32_t s_TextureCacheMagic = 0x31435854; // "TXC1"
+
+	struct TextureCacheHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t Format;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t LevelCount;
+	};
+
+	struct TextureCacheLevel
+	{
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+	// FNV-1a
+	static void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	static std::filesystem::path GetCacheFilepath(uint64_t key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.tex", (unsigned long long)key);
+		return std::filesystem::path(VulkanContext::Get()->GetConfig().TextureCachePath) / name;
+	}
+
+	static bool IsFormatSampleable(VkFormat format)
+	{
+		auto physicalDevice = VulkanContext::Get()->GetDevice()->GetPhysicalDevice();
+		if (TextureCompressor::IsCompressedFormat(format) && !physicalDevice->GetFeatures().textureCompressionBC)
+			return false;
+
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice->GetVulkanPhysicalDevice(), format, &properties);
+		return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+	}
+
+	static float SRGBToLinear(uint8_t value)
+	{
+		static const std::array<float, 256> table = []()
+		{
+			std::array<float, 256> result;
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				float c = i / 255.0f;
+				result[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return result;
+		}();
+		return table[value];
+	}
+
+	static uint8_t LinearToSRGB(float value)
+	{
+		float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		return (uint8_t)std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f);
+	}
+
+	static uint8_t ToUNorm8(float value)
+	{
+		return (uint8_t)std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f);
+	}
+
+	// 2x2盒式滤波；sRGB颜色在线性空间平均，法线平均后重新归一化，alpha始终线性平均
+	static std::vector<uint8_t> Downsample(const std::vector<uint8_t>& src, uint32_t width, uint32_t height, uint32_t dstWidth, uint32_t dstHeight, bool normalMap)
+	{
+		std::vector<uint8_t> dst((size_t)dstWidth * dstHeight * 4);
+		for (uint32_t y = 0; y < dstHeight; y++)
+		{
+			for (uint32_t x = 0; x < dstWidth; x++)
+			{
+				float sum[4] = {};
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					uint32_t sx = std::min(x * 2 + (i & 1), width - 1);
+					uint32_t sy = std::min(y * 2 + (i >> 1), height - 1);
+					const uint8_t* texel = &src[((size_t)sy * width + sx) * 4];
+					for (uint32_t c = 0; c < 3; c++)
+						sum[c] += normalMap ? texel[c] / 127.5f - 1.0f : SRGBToLinear(texel[c]);
+					sum[3] += texel[3] / 255.0f;
+				}
+
+				uint8_t* out = &dst[((size_t)y * dstWidth + x) * 4];
+				if (normalMap)
+				{
+					float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+					for (uint32_t c = 0; c < 3; c++)
+						out[c] = ToUNorm8(length > 0.0f ? (sum[c] / length) * 0.5f + 0.5f : 0.5f);
+				}
+				else
+				{
+					for (uint32_t c = 0; c < 3; c++)
+						out[c] = LinearToSRGB(sum[c] * 0.25f);
+				}
+				out[3] = ToUNorm8(sum[3] * 0.25f);
+			}
+		}
+		return dst;
+	}
+
+}
+
+bool VulkanTextureCache::Load(const TextureBakeInfo& info, BakedTexture& outTexture)
+{
+	uint64_t key = ComputeKey(info);
+	if (Load(key, outTexture))
+	{
+		CORE_INFO("Texture '{0}' loaded from cache", info.Filepath);
+		return true;
+	}
+
+	if (!Bake(info, outTexture))
+		return false;
+
+	Store(key, outTexture);
+	CORE_INFO("Texture '{0}' baked ({1}x{2}, {3} levels, {4} bytes)", info.Filepath, outTexture.Width, outTexture.Height, outTexture.Levels.size(), outTexture.DataSize);
+	return true;
+}
+
+uint64_t VulkanTextureCache::ComputeKey(const TextureBakeInfo& info)
+{
+	uint64_t hash = 14695981039346656037ull;
+	Utils::HashBytes(hash, &Utils::s_TextureCacheVersion, sizeof(Utils::s_TextureCacheVersion));
+	Utils::HashBytes(hash, &info.NormalMap, sizeof(info.NormalMap));
+
+	// 同一份缓存换到压缩格式支持不同的设备上时需要重新烘焙
+	VkFormat formats[] = { SelectFormat(false, false), SelectFormat(false, true), SelectFormat(true, false) };
+	Utils::HashBytes(hash, formats, sizeof(formats));
+
+	// 源文件按绝对路径、大小与修改时间识别，命中缓存时不再读取源文件
+	std::error_code error;
+	std::filesystem::path filepath = std::filesystem::weakly_canonical(info.Filepath, error);
+	if (error)
+		filepath = info.Filepath;
+	std::string pathString = filepath.generic_string();
+	Utils::HashBytes(hash, pathString.data(), pathString.size());
+
+	uint64_t fileSize = std::filesystem::file_size(filepath, error);
+	if (error)
+		fileSize = 0;
+	int64_t writeTime = std::filesystem::last_write_time(filepath, error).time_since_epoch().count();
+	if (error)
+		writeTime = 0;
+	Utils::HashBytes(hash, &fileSize, sizeof(fileSize));
+	Utils::HashBytes(hash, &writeTime, sizeof(writeTime));
+	return hash;
+}
+
+bool VulkanTextureCache::Load(uint64_t key, BakedTexture& outTexture)
+{
+	MappedFile& file = outTexture.File;
+	if (!file.Open(Utils::GetCacheFilepath(key)))
+		return false;
+
+	uint64_t fileSize = file.GetSize();
+
+	// 未命中时解除映射，之后烘焙的结果才能替换这个文件
+	auto miss = [&file]()
+	{
+		file.Close();
+		return false;
+	};
+
+	Utils::TextureCacheHeader header;
+	if (fileSize < sizeof(header))
+		return miss();
+	memcpy(&header, file.GetData(), sizeof(header));
+	if (header.Magic != Utils::s_TextureCacheMagic || header.Version != Utils::s_TextureCacheVersion || header.LevelCount == 0)
+		return miss();
+
+	uint64_t dataOffset = sizeof(header) + (uint64_t)header.LevelCount * sizeof(Utils::TextureCacheLevel);
+	if (fileSize < dataOffset)
+		return miss();
+
+	std::vector<Utils::TextureCacheLevel> levels(header.LevelCount);
+	memcpy(levels.data(), file.GetData() + sizeof(header), levels.size() * sizeof(Utils::TextureCacheLevel));
+
+	outTexture.Format = (VkFormat)header.Format;
+	outTexture.Width = header.Width;
+	outTexture.Height = header.Height;
+	outTexture.Levels.resize(header.LevelCount);
+	for (uint32_t i = 0; i < header.LevelCount; i++)
+	{
+		auto& level = outTexture.Levels[i];
+		level.Offset = levels[i].Offset;
+		level.Size = levels[i].Size;
+		level.Width = std::max(header.Width >> i, 1u);
+		level.Height = std::max(header.Height >> i, 1u);
+
+		// 截断或损坏的条目当作未命中，重新烘焙后覆盖
+		if (level.Size != TextureCompressor::GetLevelSize(outTexture.Format, level.Width, level.Height) || dataOffset + level.Offset + level.Size > fileSize)
+			return miss();
+	}
+
+	// 级别数据直接引用映射，上传时从这里拷贝到暂存环
+	outTexture.Data = file.GetData() + dataOffset;
+	outTexture.DataSize = fileSize - dataOffset;
+	return true;
+}
+
+void VulkanTextureCache::Store(uint64_t key, const BakedTexture& texture)
+{
+	std::filesystem::path filepath = Utils::GetCacheFilepath(key);
+
+	std::error_code error;
+	std::filesystem::create_directories(filepath.parent_path(), error);
+
+	Utils::TextureCacheHeader header;
+	header.Magic = Utils::s_TextureCacheMagic;
+	header.Version = Utils::s_TextureCacheVersion;
+	header.Format = (uint32_t)texture.Format;
+	header.Width = texture.Width;
+	header.Height = texture.Height;
+	header.LevelCount = (uint32_t)texture.Levels.size();
+
+	// 先写临时文件再替换，多个线程烘焙同一纹理时也不会读到写了一半的文件
+	std::filesystem::path tempPath = filepath;
+	tempPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			CORE_WARN("Failed to write texture cache entry '{0}'", tempPath.string());
+			return;
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		for (const auto& level : texture.Levels)
+		{
+			Utils::TextureCacheLevel entry = { level.Offset, level.Size };
+			file.write((const char*)&entry, sizeof(entry));
+		}
+		file.write((const char*)texture.Data, texture.DataSize);
+	}
+
+	std::filesystem::rename(tempPath, filepath, error);
+	if (error)
+	{
+		CORE_WARN("Failed to write texture cache entry '{0}': {1}", filepath.string(), error.message());
+		std::filesystem::remove(tempPath, error);
+	}
+}
+
+bool VulkanTextureCache::Bake(const TextureBakeInfo& info, BakedTexture& outTexture)
+{
+	int width, height, channels;
+	stbi_uc* pixels = stbi_load(info.Filepath.c_str(), &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		CORE_ERROR("Failed to load texture '{0}': {1}", info.Filepath, stbi_failure_reason());
+		return false;
+	}
+
+	std::vector<uint8_t> level(pixels, pixels + (size_t)width * height * 4);
+	stbi_image_free(pixels);
+
+	bool hasAlpha = false;
+	for (size_t i = 3; i < level.size() && !hasAlpha; i += 4)
+		hasAlpha = level[i] != 255;
+
+	outTexture.Format = SelectFormat(info.NormalMap, hasAlpha);
+	outTexture.Width = (uint32_t)width;
+	outTexture.Height = (uint32_t)height;
+
+	uint32_t mipLevels = GetMipLevelCount(outTexture.Width, outTexture.Height);
+	outTexture.Levels.resize(mipLevels);
+
+	uint64_t totalSize = 0;
+	for (uint32_t i = 0; i < mipLevels; i++)
+	{
+		auto& entry = outTexture.Levels[i];
+		entry.Width = std::max(outTexture.Width >> i, 1u);
+		entry.Height = std::max(outTexture.Height >> i, 1u);
+		entry.Offset = totalSize;
+		entry.Size = TextureCompressor::GetLevelSize(outTexture.Format, entry.Width, entry.Height);
+		// 每级起点按16字节对齐，满足拷贝时bufferOffset的要求
+		totalSize += (entry.Size + 15) & ~15ull;
+	}
+	outTexture.Storage.assign(totalSize, 0);
+	outTexture.Data = outTexture.Storage.data();
+	outTexture.DataSize = totalSize;
+
+	for (uint32_t i = 0; i < mipLevels; i++)
+	{
+		const auto& entry = outTexture.Levels[i];
+		if (i > 0)
+		{
+			const auto& previous = outTexture.Levels[i - 1];
+			level = Utils::Downsample(level, previous.Width, previous.Height, entry.Width, entry.Height, info.NormalMap);
+		}
+		TextureCompressor::Compress(outTexture.Format, level.data(), entry.Width, entry.Height, outTexture.Storage.data() + entry.Offset);
+	}
+	return true;
+}
+
+VkFormat VulkanTextureCache::SelectFormat(bool normalMap, bool hasAlpha)
+{
+	if (normalMap)
+		return Utils::IsFormatSampleable(VK_FORMAT_BC5_UNORM_BLOCK) ? VK_FORMAT_BC5_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+
+	VkFormat compressed = hasAlpha ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+	return Utils::IsFormatSampleable(compressed) ? compressed : VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+uint32_t VulkanTextureCache::GetMipLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t levels = 1;
+	for (uint32_t size = std::min(width, height); size > 1; size >>= 1)
+		levels++;
+	return levels;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "Vulkan.h"
+
+#include "Base/MappedFile.h"
+
+// 烘焙好的纹理：所有mip级别按级别顺序连续存放，可直接拷贝到图像
+// 从缓存读取时Data指向映射的文件，刚烘焙时指向Storage；销毁后Data失效，上传完成后即可释放
+struct BakedTexture
+{
+	struct Level
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+	};
+
+	VkFormat Format = VK_FORMAT_UNDEFINED;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	std::vector<Level> Levels;
+
+	const uint8_t* Data = nullptr;
+	uint64_t DataSize = 0;
+
+	std::vector<uint8_t> Storage;
+	MappedFile File;
+
+	// 解除映射并释放烘焙数据，级别信息保留
+	void Release()
+	{
+		File.Close();
+		Storage = {};
+		Data = nullptr;
+		DataSize = 0;
+	}
+};
+
+// 一次烘焙的全部输入，决定了缓存键
+struct TextureBakeInfo
+{
+	std::string Filepath;
+	// 法线贴图使用BC5（只保存xy）并按线性空间处理
+	bool NormalMap = false;
+};
+
+// 纹理磁盘缓存
+// 第一次加载时解码源图像，在线性空间中生成全部mip，按设备支持的格式压缩后写入缓存：
+// 法线贴图为BC5，带alpha为BC3，否则为BC1，设备不支持BC时保持R8G8B8A8。
+// 键包含源文件的路径、大小与修改时间、烘焙选项与设备支持的压缩格式，之后的加载直接读取压缩块上传
+class VulkanTextureCache
+{
+public:
+	// 命中缓存时直接读取，否则烘焙并写入缓存；源文件无法解码时返回false
+	static bool Load(const TextureBakeInfo& info, BakedTexture& outTexture);
+
+	static uint64_t ComputeKey(const TextureBakeInfo& info);
+	// 映射缓存文件，不复制数据
+	static bool Load(uint64_t key, BakedTexture& outTexture);
+	static void Store(uint64_t key, const BakedTexture& texture);
+
+	// 解码源图像、生成mip并压缩
+	static bool Bake(const TextureBakeInfo& info, BakedTexture& outTexture);
+	// 按设备的格式支持选择压缩格式
+	static VkFormat SelectFormat(bool normalMap, bool hasAlpha);
+	// 与VulkanTexture::GetMipLevelCount()一致
+	static uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+};
@@ -0,0 +1,315 @@
+#include "pch.h"
+#include "VulkanUploadBatch.h"
+
+#include "VulkanContext.h"
+
+VulkanUploadHandle::VulkanUploadHandle(VkDevice device, VulkanSyncPool& syncPool, VkFence fence, VkCommandPool graphicsCommandPool, VkCommandPool transferCommandPool, VkSemaphore transferSemaphore)
+	: m_Device(device), m_SyncPool(syncPool), m_Fence(fence), m_GraphicsCommandPool(graphicsCommandPool), m_TransferCommandPool(transferCommandPool), m_TransferSemaphore(transferSemaphore)
+{
+}
+
+VulkanUploadHandle::~VulkanUploadHandle()
+{
+	// 句柄可能在设备销毁流程中由暂存环释放，因此直接持有VkDevice与回收池
+	Wait();
+	RunCompletionCallbacks();
+
+	// 提交已完成，信号量已被图形队列等待过，可以直接归还
+	m_SyncPool.ReleaseFence(m_Fence);
+	m_SyncPool.ReleaseSemaphore(m_TransferSemaphore);
+
+	// 销毁命令池会一并释放其中的命令缓冲区
+	vkDestroyCommandPool(m_Device, m_GraphicsCommandPool, nullptr);
+	if (m_TransferCommandPool)
+		vkDestroyCommandPool(m_Device, m_TransferCommandPool, nullptr);
+}
+
+bool VulkanUploadHandle::IsComplete()
+{
+	if (m_Complete)
+		return true;
+
+	if (vkGetFenceStatus(m_Device, m_Fence) != VK_SUCCESS)
+		return false;
+
+	m_Complete = true;
+	RunCompletionCallbacks();
+	return true;
+}
+
+void VulkanUploadHandle::Wait()
+{
+	if (m_Complete)
+		return;
+
+	VK_CHECK_RESULT(vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, UINT64_MAX));
+	m_Complete = true;
+	RunCompletionCallbacks();
+}
+
+void VulkanUploadHandle::AddCompletionCallback(std::function<void()> func)
+{
+	{
+		std::scoped_lock lock(m_CallbackMutex);
+		m_CompletionCallbacks.push_back(std::move(func));
+	}
+
+	// 添加之前可能已经观察到完成
+	if (m_Complete)
+		RunCompletionCallbacks();
+}
+
+void VulkanUploadHandle::RunCompletionCallbacks()
+{
+	// 取出后在锁外执行，每个回调只执行一次
+	std::vector<std::function<void()>> callbacks;
+	{
+		std::scoped_lock lock(m_CallbackMutex);
+		callbacks.swap(m_CompletionCallbacks);
+	}
+
+	for (auto& callback : callbacks)
+		callback();
+}
+
+VulkanUploadBatch::VulkanUploadBatch()
+{
+}
+
+VulkanUploadBatch::~VulkanUploadBatch()
+{
+	// 未提交的批次在析构时提交并等待，保证记录的拷贝不会丢失
+	if (!IsEmpty())
+		Submit()->Wait();
+}
+
+void VulkanUploadBatch::UploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+{
+	StagingRegion region = AllocateStaging(size, 16);
+	memcpy(region.Data, data, static_cast<size_t>(size));
+
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = region.Offset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(m_TransferCommandBuffer, region.Buffer, dstBuffer, 1, &copyRegion);
+
+	if (m_UseTransferQueue)
+	{
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.buffer = dstBuffer;
+		barrier.offset = dstOffset;
+		barrier.size = size;
+		TransferOwnership(barrier);
+	}
+}
+
+void VulkanUploadBatch::UploadImage(VkImage image, const void* data, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange)
+{
+	// bufferOffset需要是texel大小的整数倍，16对所有未压缩格式与BC块都成立
+	StagingRegion region = AllocateStaging(size, 16);
+	memcpy(region.Data, data, static_cast<size_t>(size));
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange = subresourceRange;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(m_TransferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	std::vector<VkBufferImageCopy> copyRegions = regions;
+	for (auto& copyRegion : copyRegions)
+		copyRegion.bufferOffset += region.Offset;
+
+	vkCmdCopyBufferToImage(m_TransferCommandBuffer, region.Buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)copyRegions.size(), copyRegions.data());
+
+	if (m_UseTransferQueue)
+	{
+		// 布局保持TRANSFER_DST_OPTIMAL，后续处理在图形队列上进行
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		TransferOwnership(barrier);
+	}
+}
+
+void VulkanUploadBatch::DeferUntilComplete(std::function<void()> func)
+{
+	m_CompletionCallbacks.push_back(std::move(func));
+}
+
+VkCommandBuffer VulkanUploadBatch::GetCommandBuffer()
+{
+	if (!m_CommandBuffer)
+		Begin();
+	return m_CommandBuffer;
+}
+
+Ref<VulkanUploadHandle> VulkanUploadBatch::Submit()
+{
+	// 空批次也返回一个已完成的句柄，调用方无需特殊处理；只有延迟回调的批次同样需要一次提交来触发它们
+	if (!m_CommandBuffer)
+		Begin();
+	return SubmitCurrent();
+}
+
+void VulkanUploadBatch::Begin()
+{
+	auto device = VulkanContext::Get()->GetDevice();
+	const auto& queueFamilyIndices = device->GetPhysicalDevice()->GetQueueFamilyIndices();
+
+	m_UseTransferQueue = device->HasTransferQueue();
+
+	// 每次提交使用独立的短期命令池，由完成句柄负责销毁，句柄可以在任意线程释放
+	m_CommandPool = CreateCommandPool(queueFamilyIndices.Graphics, m_CommandBuffer);
+	if (m_UseTransferQueue)
+		m_TransferCommandPool = CreateCommandPool(queueFamilyIndices.Transfer, m_TransferCommandBuffer);
+	else
+		m_TransferCommandBuffer = m_CommandBuffer;
+}
+
+VkCommandPool VulkanUploadBatch::CreateCommandPool(uint32_t queueFamilyIndex, VkCommandBuffer& outCommandBuffer)
+{
+	auto device = VulkanContext::Get()->GetCurrentDevice();
+
+	VkCommandPool commandPool;
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = queueFamilyIndex;
+	VK_CHECK_RESULT(vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool));
+
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &allocInfo, &outCommandBuffer));
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VK_CHECK_RESULT(vkBeginCommandBuffer(outCommandBuffer, &beginInfo));
+
+	return commandPool;
+}
+
+void VulkanUploadBatch::TransferOwnership(VkBufferMemoryBarrier barrier)
+{
+	const auto& queueFamilyIndices = VulkanContext::Get()->GetDevice()->GetPhysicalDevice()->GetQueueFamilyIndices();
+	barrier.srcQueueFamilyIndex = queueFamilyIndices.Transfer;
+	barrier.dstQueueFamilyIndex = queueFamilyIndices.Graphics;
+
+	// 释放：在传输队列上完成写入
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(m_TransferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	// 获取：图形队列在等待信号量（TRANSFER阶段）之后取得所有权
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void VulkanUploadBatch::TransferOwnership(VkImageMemoryBarrier barrier)
+{
+	const auto& queueFamilyIndices = VulkanContext::Get()->GetDevice()->GetPhysicalDevice()->GetQueueFamilyIndices();
+	barrier.srcQueueFamilyIndex = queueFamilyIndices.Transfer;
+	barrier.dstQueueFamilyIndex = queueFamilyIndices.Graphics;
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(m_TransferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+StagingRegion VulkanUploadBatch::AllocateStaging(VkDeviceSize size, VkDeviceSize alignment)
+{
+	auto& stagingRing = VulkanContext::Get()->GetDevice()->GetStagingRing();
+
+	// 本批次未提交的区间无法被回收，占用超过半个环时先提交已记录的部分
+	if (m_CommandBuffer && m_StagedBytes + size > stagingRing.GetSize() / 2)
+		SubmitCurrent();
+
+	if (!m_CommandBuffer)
+		Begin();
+
+	StagingRegion region = stagingRing.Allocate(size, alignment);
+	m_StagingRegions.push_back(region);
+	m_StagedBytes += size;
+	return region;
+}
+
+Ref<VulkanUploadHandle> VulkanUploadBatch::SubmitCurrent()
+{
+	auto device = VulkanContext::Get()->GetDevice();
+	auto vulkanDevice = device->GetVulkanDevice();
+
+	// 让拷贝结果对之后图形队列上的所有读取可见，使用方不需要再插入屏障
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	VK_CHECK_RESULT(vkEndCommandBuffer(m_CommandBuffer));
+
+	auto& syncPool = device->GetSyncPool();
+	VkFence fence = syncPool.AcquireFence();
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &m_CommandBuffer;
+
+	VkSemaphore transferSemaphore = nullptr;
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	if (m_UseTransferQueue)
+	{
+		VK_CHECK_RESULT(vkEndCommandBuffer(m_TransferCommandBuffer));
+
+		transferSemaphore = syncPool.AcquireSemaphore();
+
+		VkSubmitInfo transferSubmitInfo{};
+		transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmitInfo.commandBufferCount = 1;
+		transferSubmitInfo.pCommandBuffers = &m_TransferCommandBuffer;
+		transferSubmitInfo.signalSemaphoreCount = 1;
+		transferSubmitInfo.pSignalSemaphores = &transferSemaphore;
+		VK_CHECK_RESULT(device->QueueSubmit(device->GetTransferQueue(), 1, &transferSubmitInfo, VK_NULL_HANDLE));
+
+		// 图形队列只在获取所有权处等待，之前提交的渲染不受影响
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &transferSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+	}
+
+	// 图形队列的提交在传输之后完成，fence可以代表整个批次
+	VK_CHECK_RESULT(device->QueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, fence));
+
+	Ref<VulkanUploadHandle> handle = CreateRef<VulkanUploadHandle>(vulkanDevice, syncPool, fence, m_CommandPool, m_TransferCommandPool, transferSemaphore);
+	for (auto& callback : m_CompletionCallbacks)
+		handle->AddCompletionCallback(std::move(callback));
+	m_CompletionCallbacks.clear();
+
+	// 暂存区间在该次提交完成后才能被覆盖
+	auto& stagingRing = device->GetStagingRing();
+	for (auto& region : m_StagingRegions)
+		stagingRing.Retire(region, handle);
+
+	m_StagingRegions.clear();
+	m_StagedBytes = 0;
+	m_CommandPool = nullptr;
+	m_CommandBuffer = nullptr;
+	m_TransferCommandPool = nullptr;
+	m_TransferCommandBuffer = nullptr;
+	return handle;
+}
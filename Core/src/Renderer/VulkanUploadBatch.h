@@ -0,0 +1,86 @@
+#pragma once
+#include "Vulkan.h"
+
+#include "Buffer/VulkanStagingRing.h"
+#include "VulkanSyncPool.h"
+
+#include <atomic>
+#include <mutex>
+
+// 一次上传提交的完成句柄，可轮询或等待
+// 句柄持有本次提交的命令池、信号量与fence，析构时等待提交完成并把同步对象归还给回收池
+class VulkanUploadHandle
+{
+public:
+	VulkanUploadHandle(VkDevice device, VulkanSyncPool& syncPool, VkFence fence, VkCommandPool graphicsCommandPool, VkCommandPool transferCommandPool = nullptr, VkSemaphore transferSemaphore = nullptr);
+	~VulkanUploadHandle();
+
+	bool IsComplete();
+	void Wait();
+
+	// func在提交完成后由第一个观察到完成的IsComplete()/Wait()调用执行，可能在任意线程上
+	void AddCompletionCallback(std::function<void()> func);
+private:
+	void RunCompletionCallbacks();
+private:
+	VkDevice m_Device = nullptr;
+	VulkanSyncPool& m_SyncPool;
+	VkFence m_Fence = nullptr;
+	VkCommandPool m_GraphicsCommandPool = nullptr;
+	VkCommandPool m_TransferCommandPool = nullptr;
+	VkSemaphore m_TransferSemaphore = nullptr;
+	std::atomic<bool> m_Complete = false;
+
+	std::vector<std::function<void()>> m_CompletionCallbacks;
+	std::mutex m_CallbackMutex;
+};
+
+// 批量上传
+// 把多次缓冲区与图像拷贝记录进同一个命令缓冲区，一次提交、一个fence
+// 暂存数据不足以放入暂存环时会先提交已记录的部分，后续提交在同一队列上按顺序执行
+//
+// 设备有独立传输队列时，拷贝记录在传输队列的命令缓冲区中并释放所有权，
+// 图形队列的命令缓冲区等待传输完成的信号量后获取所有权，再执行GetCommandBuffer()中记录的后续处理
+class VulkanUploadBatch
+{
+public:
+	VulkanUploadBatch();
+	~VulkanUploadBatch();
+
+	void UploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+	// regions中的bufferOffset相对于data起始位置；图像所有子资源会从UNDEFINED转换为TRANSFER_DST_OPTIMAL
+	void UploadImage(VkImage image, const void* data, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange);
+
+	// 图形队列上的命令缓冲区，用于记录拷贝之后的处理（生成mip、布局转换等）
+	// UploadBuffer/UploadImage在暂存空间不足时会提交已记录的部分并换新的命令缓冲区，上传之后要重新取得
+	VkCommandBuffer GetCommandBuffer();
+
+	Ref<VulkanUploadHandle> Submit();
+	// func在到目前为止记录的命令所在的提交完成后执行，用于释放这些命令仍在使用的资源
+	// 批次中途提交时只跟随已记录部分的句柄，不必等到整个批次完成
+	void DeferUntilComplete(std::function<void()> func);
+	bool IsEmpty() const { return m_CommandBuffer == nullptr && m_CompletionCallbacks.empty(); }
+private:
+	void Begin();
+	StagingRegion AllocateStaging(VkDeviceSize size, VkDeviceSize alignment);
+	Ref<VulkanUploadHandle> SubmitCurrent();
+	VkCommandPool CreateCommandPool(uint32_t queueFamilyIndex, VkCommandBuffer& outCommandBuffer);
+
+	// 传输队列 -> 图形队列的所有权转移
+	void TransferOwnership(VkBufferMemoryBarrier barrier);
+	void TransferOwnership(VkImageMemoryBarrier barrier);
+private:
+	bool m_UseTransferQueue = false;
+
+	// 图形队列
+	VkCommandPool m_CommandPool = nullptr;
+	VkCommandBuffer m_CommandBuffer = nullptr;
+
+	// 传输队列，未启用时拷贝直接记录在m_CommandBuffer中
+	VkCommandPool m_TransferCommandPool = nullptr;
+	VkCommandBuffer m_TransferCommandBuffer = nullptr;
+
+	std::vector<StagingRegion> m_StagingRegions;
+	std::vector<std::function<void()>> m_CompletionCallbacks;
+	VkDeviceSize m_StagedBytes = 0;
+};